@@ -0,0 +1,38 @@
+#ifndef BENCH_HPP
+#define BENCH_HPP
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+
+namespace bench {
+  // Keeps the compiler from removing the computation of `value`
+  template <typename T> inline void keep(const T &value) {
+#if defined(__GNUC__)
+    asm volatile("" : : "g"(&value) : "memory");
+#else
+    static volatile const void *sink;
+    sink = &value;
+#endif
+  }
+
+  // Best time per operation, in nanoseconds, of `repeats` runs of `f`, each
+  // of which performs `ops` operations
+  template <typename F>
+  double ns_per_op(std::size_t ops, F &&f, int repeats = 5) {
+    double best = 0;
+    for (int i = 0; i < repeats; ++i) {
+      auto start = std::chrono::steady_clock::now();
+      f();
+      auto stop = std::chrono::steady_clock::now();
+      std::chrono::duration<double, std::nano> ns = stop - start;
+      best = i == 0 || ns.count() < best ? ns.count() : best;
+    }
+    return best / ops;
+  }
+
+  inline void report(const char *name, double ns) {
+    std::printf("%-32s %8.2f ns/op\n", name, ns);
+  }
+} // namespace bench
+
+#endif
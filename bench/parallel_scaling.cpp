@@ -0,0 +1,89 @@
+// Throughput of `parallel_transform` and `parallel_for_each` with pools of 1
+// to `std::thread::hardware_concurrency()` threads. Build with e.g.
+//   g++ -std=c++17 -O2 -pthread -I. bench/parallel_scaling.cpp
+#include "bench.hpp"
+#include "safe_parallel.hpp"
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+
+using namespace logic;
+
+constexpr std::size_t size = 1 << 22;
+
+// Enough arithmetic per element for the work not to be bound by memory
+double iterate(double x) {
+  for (int i = 0; i < 32; ++i) {
+    x = x * 0.999 + 0.5;
+  }
+  return x;
+}
+
+double twice_plus_one(double x) { return x * 2 + 1; }
+
+double halve_plus_one(double x) { return x * 0.5 + 1; }
+
+// Exits unless `arr` holds `f(i)` at every index `i`, i.e. every element was
+// processed exactly once by each run
+template <typename F>
+void check(const safe_array<double, size> &arr, F f, const char *name) {
+  for (std::size_t i = 0; i < size; ++i) {
+    if (arr.m_data[i] != f(static_cast<double>(i))) {
+      std::fprintf(stderr, "%s: wrong result at %zu\n", name, i);
+      std::exit(1);
+    }
+  }
+}
+
+int main() {
+  auto in = std::make_unique<safe_array<double, size>>();
+  auto out = std::make_unique<safe_array<double, size>>();
+  for (std::size_t i = 0; i < size; ++i) {
+    in->m_data[i] = static_cast<double>(i);
+  }
+
+  std::size_t max_threads = thread_pool::default_threads();
+  double base[3] = {};
+  std::printf("Millions of elements per second (speedup over 1 thread)\n");
+  std::printf("%7s %24s %24s %24s\n", "threads", "transform",
+              "heavy transform", "for_each");
+  for (std::size_t k = 1; k <= max_threads; ++k) {
+    thread_pool pool{k};
+    double ns[3];
+    ns[0] = bench::ns_per_op(size, [&] {
+      parallel_transform(*in, *out, twice_plus_one, pool);
+      bench::keep(*out);
+    });
+    check(*out, twice_plus_one, "transform");
+    ns[1] = bench::ns_per_op(size, [&] {
+      parallel_transform(*in, *out, iterate, pool);
+      bench::keep(*out);
+    });
+    check(*out, iterate, "heavy transform");
+    int runs = 0;
+    ns[2] = bench::ns_per_op(size, [&] {
+      parallel_for_each(*out, [](double &x) { x = halve_plus_one(x); }, pool);
+      bench::keep(*out);
+      ++runs;
+    });
+    check(
+     *out,
+     [&](double x) {
+       x = iterate(x);
+       for (int i = 0; i < runs; ++i) {
+         x = halve_plus_one(x);
+       }
+       return x;
+     },
+     "for_each");
+    std::printf("%7zu", k);
+    for (int i = 0; i < 3; ++i) {
+      base[i] = k == 1 ? ns[i] : base[i];
+      std::printf(" %14.1f (x%5.2f)", 1e3 / ns[i], base[i] / ns[i]);
+    }
+    std::printf("\n");
+  }
+  return 0;
+}
@@ -0,0 +1,54 @@
+#!/bin/sh
+# Time to rebuild translation units using the library, as after editing them:
+#  - plain: every unit parses the headers and instantiates what it uses;
+#  - pch: `logic_all.hpp` is precompiled and included first, and with
+#    `LOGIC_EXTERN_TEMPLATES` the common specializations are taken from
+#    `logic_instantiations.cpp` instead of being instantiated again.
+# The precompiled header and `logic_instantiations.o` are built once, before
+# timing, as they are in an incremental build. Usage:
+#   bench/rebuild_time.sh [compiler] [rebuilds]
+set -eu
+cd "$(dirname "$0")/.."
+
+cxx=${1:-g++}
+rebuilds=${2:-5}
+# Units using the library like client code; logic.cpp is left out, as most of
+# its build time goes to the constant evaluation of its tests
+units="bench/safe_overhead.cpp bench/search.cpp codegen/overhead.cpp
+       codegen/hints.cpp"
+flags="-std=c++17 -O2 -I."
+out=$(mktemp -d)
+trap 'rm -rf "$out"' EXIT
+
+now() {
+  date +%s.%N
+}
+
+# Seconds taken by $rebuilds builds of every unit, with extra flags $1
+rebuild() {
+  start=$(now)
+  i=0
+  while [ $i -lt "$rebuilds" ]; do
+    for unit in $units; do
+      # shellcheck disable=SC2086
+      $cxx $flags $1 -c "$unit" -o "$out/unit.o"
+    done
+    i=$((i + 1))
+  done
+  echo "$start $(now)" | awk '{ printf "%.2f", $2 - $1 }'
+}
+
+pch_flags="-DLOGIC_EXTERN_TEMPLATES"
+cp logic_all.hpp logic.hpp safe*.hpp "$out"
+# shellcheck disable=SC2086
+$cxx $flags $pch_flags -x c++-header "$out/logic_all.hpp" \
+  -o "$out/logic_all.hpp.gch"
+# shellcheck disable=SC2086
+$cxx $flags -c logic_instantiations.cpp -o "$out/logic_instantiations.o"
+
+plain=$(rebuild "")
+pch=$(rebuild "$pch_flags -Winvalid-pch -include $out/logic_all.hpp")
+echo "$rebuilds rebuilds of" $units "with $cxx"
+echo "$plain $pch" | awk '{
+  printf "plain %8.2f s\npch   %8.2f s (%.0f%% saved)\n", $1, $2,
+         100 * ($1 - $2) / $1 }'
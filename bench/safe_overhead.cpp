@@ -0,0 +1,109 @@
+// Runtime cost of `safe` and `safe_array` against the raw operations they
+// replace. Build with optimizations, e.g.
+//   g++ -std=c++17 -O2 -I. bench/safe_overhead.cpp -o safe_overhead
+#include "bench.hpp"
+#include "safe_array.hpp"
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace logic;
+
+constexpr std::size_t size = 1 << 16;
+using index_type = safe_array<int, size>::accessor_type;
+using value = safe<int, between_inclusive<int, 0, 1000>>;
+
+// The range test `value(int)` performs, written by hand
+int checked(int x) {
+  if (x < 0 || x > 1000) {
+    throw std::range_error{"value"};
+  }
+  return x;
+}
+
+int main() {
+  std::mt19937 rng{1};
+
+  auto raw_array = std::make_unique<std::array<int, size>>();
+  auto safe_arr = std::make_unique<safe_array<int, size>>();
+  std::vector<std::size_t> raw_indices(size);
+  std::vector<index_type> safe_indices;
+  for (std::size_t i = 0; i < size; ++i) {
+    (*raw_array)[i] = safe_arr->m_data[i] = static_cast<int>(rng() % 1000);
+    raw_indices[i] = rng() % size;
+    safe_indices.push_back(raw_indices[i]);
+  }
+
+  std::vector<int> raw_lhs(size), raw_rhs(size);
+  std::vector<value> safe_lhs, safe_rhs;
+  for (std::size_t i = 0; i < size; ++i) {
+    raw_lhs[i] = static_cast<int>(rng() % 1001);
+    raw_rhs[i] = static_cast<int>(rng() % 1001);
+    safe_lhs.push_back(raw_lhs[i]);
+    safe_rhs.push_back(raw_rhs[i]);
+  }
+
+  auto run = [](const char *name, auto op) {
+    bench::report(name, bench::ns_per_op(size, [&] {
+                    long long total = 0;
+                    for (std::size_t i = 0; i < size; ++i) {
+                      total += op(i);
+                    }
+                    bench::keep(total);
+                  }));
+  };
+
+  std::printf("Indexing\n");
+  run("std::array []", [&](std::size_t i) {
+    return (*raw_array)[raw_indices[i]];
+  });
+  run("std::array at()", [&](std::size_t i) {
+    return raw_array->at(raw_indices[i]);
+  });
+  run("safe_array []", [&](std::size_t i) {
+    return (*safe_arr)[safe_indices[i]];
+  });
+
+  std::printf("Addition\n");
+  run("int +", [&](std::size_t i) { return raw_lhs[i] + raw_rhs[i]; });
+  run("__builtin_add_overflow", [&](std::size_t i) {
+    int res;
+    if (__builtin_add_overflow(raw_lhs[i], raw_rhs[i], &res)) {
+      throw std::overflow_error{"+"};
+    }
+    return res;
+  });
+  run("safe +", [&](std::size_t i) { return int(safe_lhs[i] + safe_rhs[i]); });
+
+  std::printf("Subtraction\n");
+  run("int -", [&](std::size_t i) { return raw_lhs[i] - raw_rhs[i]; });
+  run("__builtin_sub_overflow", [&](std::size_t i) {
+    int res;
+    if (__builtin_sub_overflow(raw_lhs[i], raw_rhs[i], &res)) {
+      throw std::overflow_error{"-"};
+    }
+    return res;
+  });
+  run("safe -", [&](std::size_t i) { return int(safe_lhs[i] - safe_rhs[i]); });
+
+  std::printf("Multiplication\n");
+  run("int *", [&](std::size_t i) { return raw_lhs[i] * raw_rhs[i]; });
+  run("__builtin_mul_overflow", [&](std::size_t i) {
+    int res;
+    if (__builtin_mul_overflow(raw_lhs[i], raw_rhs[i], &res)) {
+      throw std::overflow_error{"*"};
+    }
+    return res;
+  });
+  run("safe *", [&](std::size_t i) { return int(safe_lhs[i] * safe_rhs[i]); });
+
+  std::printf("Checked construction\n");
+  run("hand-written range test", [&](std::size_t i) {
+    return checked(raw_lhs[i]);
+  });
+  run("safe(T)", [&](std::size_t i) { return int(value(raw_lhs[i])); });
+  return 0;
+}
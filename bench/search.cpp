@@ -0,0 +1,62 @@
+// Repeated searches in a large sorted array: `std::lower_bound` against the
+// branchless `lower_bound` and `eytzinger_array`. Build with e.g.
+//   g++ -std=c++17 -O2 -I. bench/search.cpp
+#include "bench.hpp"
+#include "safe_algorithm.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace logic;
+
+constexpr std::size_t size = 1 << 23;
+
+int main() {
+  auto sorted = std::make_unique<safe_array<int, size>>();
+  for (std::size_t i = 0; i < size; ++i) {
+    sorted->m_data[i] = static_cast<int>(i * 2);
+  }
+  auto tree = std::make_unique<eytzinger_array<int, size>>(*sorted);
+
+  std::mt19937 rng{1};
+  std::vector<int> queries(1 << 21);
+  for (auto &q : queries) {
+    q = static_cast<int>(rng() % (2 * size));
+  }
+
+  auto run = [&](const char *name, auto search) {
+    bench::report(name, bench::ns_per_op(queries.size(), [&] {
+                    std::size_t total = 0;
+                    for (int q : queries) {
+                      total += search(q);
+                    }
+                    bench::keep(total);
+                  }));
+  };
+
+  auto &data = sorted->array();
+  std::printf("%zu ints, %zu random searches\n", size, queries.size());
+  run("std::lower_bound", [&](int q) {
+    return std::size_t(std::lower_bound(data.begin(), data.end(), q) -
+                       data.begin());
+  });
+  run("branchless lower_bound", [&](int q) {
+    return std::size_t(lower_bound(*sorted, q));
+  });
+  run("eytzinger_array::lower_bound", [&](int q) {
+    return std::size_t(tree->lower_bound(q));
+  });
+  run("std::upper_bound", [&](int q) {
+    return std::size_t(std::upper_bound(data.begin(), data.end(), q) -
+                       data.begin());
+  });
+  run("branchless upper_bound", [&](int q) {
+    return std::size_t(upper_bound(*sorted, q));
+  });
+  run("eytzinger_array::upper_bound", [&](int q) {
+    return std::size_t(tree->upper_bound(q));
+  });
+  return 0;
+}
@@ -0,0 +1,97 @@
+#!/bin/sh
+# Disassembly checks of code built by each compiler given on the command line
+# (g++ and clang++ by default):
+#  - every `safe_<name>` function in overhead.cpp, built with -O2 and -O3, must
+#    have at most as many instructions as `raw_<name>`, and at least as many
+#    vector instructions, so that a loop the compiler no longer vectorizes is
+#    not mistaken for a shorter one;
+#  - every function in hints.cpp, built with -O2, must have fewer instructions
+#    than when built with `LOGIC_NO_ASSUME`, i.e. the optimiser hints must
+#    remove checks. This is skipped for compilers defining
+#    `LOGIC_ASSUME_BRANCHES` (GCC before 13), where `safe` reads carry no
+#    hints.
+set -eu
+cd "$(dirname "$0")/.."
+
+compilers=${*:-"g++ clang++"}
+out=$(mktemp -d)
+trap 'rm -rf "$out"' EXIT
+failed=0
+
+# Instructions of function $2 in object $1, including its cold part, without
+# the padding between functions
+instructions() {
+  objdump -dr --no-show-raw-insn "$1" | awk -v sym="$2" '
+    /^[0-9a-f]+ <.*>:$/ {
+      name = substr($2, 2, length($2) - 3)
+      inside = name == sym || name == sym ".cold"
+      next
+    }
+    inside && /^ +[0-9a-f]+:\t/ && !/\tnop|\txchg +%ax,%ax|\tint3/'
+}
+
+count() {
+  instructions "$1" "$2" | wc -l | tr -d ' '
+}
+
+# Instructions of function $2 in object $1 using vector registers
+count_vector() {
+  instructions "$1" "$2" | grep -c '%[xyz]mm' || true
+}
+
+# Whether compiler $1 defines `LOGIC_ASSUME_BRANCHES`
+assume_branches() {
+  printf '#include "safe.hpp"\n#ifndef LOGIC_ASSUME_BRANCHES\n#error\n%s\n' \
+    '#endif' | "$1" -std=c++17 -I. -fsyntax-only -x c++ - 2>/dev/null
+}
+
+for cxx in $compilers; do
+  if ! command -v "$cxx" >/dev/null; then
+    echo "$cxx: not found, skipped"
+    continue
+  fi
+  for opt in -O2 -O3; do
+    obj="$out/overhead-$cxx$opt.o"
+    "$cxx" -std=c++17 "$opt" -I. -c codegen/overhead.cpp -o "$obj"
+    functions=$(nm "$obj" |
+                awk '$3 ~ /^raw_[a-z_]*$/ { print substr($3, 5) }')
+    for fn in $functions; do
+      raw=$(count "$obj" "raw_$fn")
+      safe=$(count "$obj" "safe_$fn")
+      raw_vector=$(count_vector "$obj" "raw_$fn")
+      safe_vector=$(count_vector "$obj" "safe_$fn")
+      status=ok
+      if [ "$safe" -gt "$raw" ] || [ "$safe_vector" -lt "$raw_vector" ]; then
+        status=FAILED
+        failed=1
+      fi
+      printf '%-8s %-3s %-10s raw %3s (%3s vector)  ' "$cxx" "$opt" "$fn" \
+        "$raw" "$raw_vector"
+      printf 'safe %3s (%3s vector)  %s\n' "$safe" "$safe_vector" "$status"
+    done
+  done
+
+  if assume_branches "$cxx"; then
+    echo "$cxx: reads carry no hints, hints.cpp skipped"
+    continue
+  fi
+  hinted="$out/hints-$cxx.o"
+  unhinted="$out/hints-$cxx-no-assume.o"
+  "$cxx" -std=c++17 -O2 -I. -c codegen/hints.cpp -o "$hinted"
+  "$cxx" -std=c++17 -O2 -I. -DLOGIC_NO_ASSUME -c codegen/hints.cpp \
+    -o "$unhinted"
+  functions=$(nm "$hinted" | awk '$2 == "T" { print $3 }')
+  for fn in $functions; do
+    with=$(count "$hinted" "$fn")
+    without=$(count "$unhinted" "$fn")
+    status=ok
+    if [ "$with" -ge "$without" ]; then
+      status=FAILED
+      failed=1
+    fi
+    printf '%-8s %-16s hints %3s  no hints %3s  %s\n' "$cxx" "$fn" "$with" \
+      "$without" "$status"
+  done
+done
+
+exit $failed
@@ -0,0 +1,35 @@
+// Loops passing the values of `safe` reads to code that checks them again.
+// `check.sh` verifies that the optimiser hints remove these checks, which are
+// kept when the hints are disabled with `LOGIC_NO_ASSUME`.
+#include "safe.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdlib>
+
+using namespace logic;
+
+using byte_index = safe<int, between_inclusive<int, 0, 255>>;
+
+extern "C" {
+int checked_lookups(const std::array<int, 256> &table,
+                    const byte_index *indices, std::size_t count) {
+  int total = 0;
+  for (std::size_t i = 0; i < count; ++i) {
+    int k = indices[i];
+    if (k < 0 || k > 255) {
+      std::abort();
+    }
+    total += table[k];
+  }
+  return total;
+}
+
+int clamped_halves(const byte_index *values, std::size_t count) {
+  int total = 0;
+  for (std::size_t i = 0; i < count; ++i) {
+    int v = values[i];
+    total += v < 0 ? 0 : v / 2;
+  }
+  return total;
+}
+}
@@ -0,0 +1,113 @@
+// Pairs of functions doing the same work with and without `safe`, compared by
+// `check.sh`: every `safe_<name>` must not have more instructions, nor fewer
+// vector instructions, than `raw_<name>`.
+#include "safe_array.hpp"
+#include "safe_counter.hpp"
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+
+using namespace logic;
+
+using value = safe<int, between_inclusive<int, 0, 1000>>;
+
+extern "C" {
+int raw_index(const std::array<int, 64> &arr, std::size_t i) { return arr[i]; }
+int safe_index(const safe_array<int, 64> &arr,
+               safe_array<int, 64>::accessor_type i) {
+  return arr[i];
+}
+
+int raw_add(int a, int b) { return a + b; }
+int safe_add(value a, value b) { return a + b; }
+
+int raw_sub(int a, int b) { return a - b; }
+int safe_sub(value a, value b) { return a - b; }
+
+int raw_mul(int a, int b) { return a * b; }
+int safe_mul(value a, value b) { return a * b; }
+
+int raw_check(int x) {
+  if (x < 0 || x > 1000) {
+    throw std::range_error{"value"};
+  }
+  return x;
+}
+int safe_check(int x) { return value(x); }
+
+int raw_add_loop(const int *a, const int *b, std::size_t n) {
+  int total = 0;
+  for (std::size_t i = 0; i < n; ++i) {
+    total += a[i] + b[i];
+  }
+  return total;
+}
+int safe_add_loop(const value *a, const value *b, std::size_t n) {
+  int total = 0;
+  for (std::size_t i = 0; i < n; ++i) {
+    total += a[i] + b[i];
+  }
+  return total;
+}
+
+int raw_sub_loop(const int *a, const int *b, std::size_t n) {
+  int total = 0;
+  for (std::size_t i = 0; i < n; ++i) {
+    total += a[i] - b[i];
+  }
+  return total;
+}
+int safe_sub_loop(const value *a, const value *b, std::size_t n) {
+  int total = 0;
+  for (std::size_t i = 0; i < n; ++i) {
+    total += a[i] - b[i];
+  }
+  return total;
+}
+
+int raw_mul_loop(const int *a, const int *b, std::size_t n) {
+  int total = 0;
+  for (std::size_t i = 0; i < n; ++i) {
+    total += a[i] * b[i];
+  }
+  return total;
+}
+int safe_mul_loop(const value *a, const value *b, std::size_t n) {
+  int total = 0;
+  for (std::size_t i = 0; i < n; ++i) {
+    total += a[i] * b[i];
+  }
+  return total;
+}
+
+// Reduction over a table of constrained elements, as built by `make_lut`
+int raw_table_sum(const std::array<int, 1024> &arr) {
+  int total = 0;
+  for (std::size_t i = 0; i < 1024; ++i) {
+    total += arr[i];
+  }
+  return total;
+}
+int safe_table_sum(const safe_array<value, 1024> &arr) {
+  int total = 0;
+  for (auto i : safe_counter<std::size_t, 0, 1023>{}) {
+    total += arr[i];
+  }
+  return total;
+}
+
+int raw_loop(const std::array<int, 64> &arr) {
+  int total = 0;
+  for (std::size_t i = 0; i < 64; ++i) {
+    total += arr[i];
+  }
+  return total;
+}
+int safe_loop(const safe_array<int, 64> &arr) {
+  int total = 0;
+  for (auto i : safe_counter<std::size_t, 0, 63>{}) {
+    total += arr[i];
+  }
+  return total;
+}
+}
@@ -1,11 +1,88 @@
 #include "logic.hpp"
 #include "safe.hpp"
+#include "safe_algorithm.hpp"
 #include "safe_array.hpp"
+#include "safe_counter.hpp"
+#include "safe_dispatch.hpp"
+#include <limits>
 
 using namespace logic;
 
 template <typename T> struct print_type;
 
+// Compares the bounds of `mul_type` on [L1, H1] * [L2, H2] with those found by
+// multiplying every pair of values
+template <typename T, T L1, T H1, T L2, T H2> constexpr bool exact_product() {
+  using lhs = normalize_t<T, typename between_inclusive<T, L1, H1>::type>;
+  using rhs = normalize_t<T, typename between_inclusive<T, L2, H2>::type>;
+  using res = domain<T, mul_type_t<lhs, rhs>>;
+  int lowest = L1 * L2;
+  int highest = L1 * L2;
+  for (int x = L1; x <= H1; ++x) {
+    for (int y = L2; y <= H2; ++y) {
+      lowest = x * y < lowest ? x * y : lowest;
+      highest = x * y > highest ? x * y : highest;
+    }
+  }
+  return res::lowest == lowest && res::highest == highest;
+}
+
+template <typename T, T L, T H> constexpr bool exact_products() {
+  if constexpr (std::is_signed_v<T>) {
+    return exact_product<T, L, H, -11, -3>() &&
+           exact_product<T, L, H, -7, 0>() &&
+           exact_product<T, L, H, -5, 6>() && exact_product<T, L, H, 0, 9>() &&
+           exact_product<T, L, H, 4, 11>();
+  } else {
+    return exact_product<T, L, H, 0, 0>() && exact_product<T, L, H, 0, 7>() &&
+           exact_product<T, L, H, 3, 15>() && exact_product<T, L, H, 10, 15>();
+  }
+}
+
+// Compares `is_multiplication_safe` with the exact product of every pair of
+// values of `T`
+template <typename T> constexpr bool exact_multiplication_checks() {
+  constexpr int lowest = std::numeric_limits<T>::lowest();
+  constexpr int highest = std::numeric_limits<T>::max();
+  for (int a = lowest; a <= highest; ++a) {
+    for (int b = lowest; b <= highest; ++b) {
+      bool fits = lowest <= a * b && a * b <= highest;
+      if (is_multiplication_safe(static_cast<T>(a), static_cast<T>(b)) !=
+          fits) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Whether `mul_type` accepts [L1, H1] * [L2, H2]
+template <typename T> constexpr bool product_accepted(T L1, T H1, T L2, T H2) {
+  return is_multiplication_safe(interval<T>{L1, H1, false},
+                                interval<T>{L2, H2, false});
+}
+
+// Pseudo-random values in [0, 10^9), too sparse for a bitset and, for a few
+// hundred of them, for a hash without collisions
+constexpr int sparse_value(std::size_t i) {
+  std::uint64_t z = (i + 1) * 0x9E3779B97F4A7C15ull;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+  return static_cast<int>((z ^ (z >> 31)) % 1000000000u);
+}
+
+template <std::size_t... Is>
+constexpr bool sparse_members(std::index_sequence<Is...>) {
+  using set = one_of<int, sparse_value(Is)...>;
+  return (is_acceptable(sparse_value(Is), set{}) && ...) &&
+         !is_acceptable(-1, set{}) && !is_acceptable(1000000000, set{});
+}
+
+template <std::size_t... Is>
+constexpr auto multiples_of_7(std::index_sequence<Is...>) {
+  return safe<int, one_of<int, int(Is * 7)...>>::template make_safe<0>();
+}
+
 int main() {
   sequent<list<and_term<greater<int, 1>,
                         or_term<less_equal<int, 2>, less_equal<int, 3>>>>,
@@ -37,8 +114,45 @@ int main() {
   static_assert(!(truth_value<decltype(untrue)>),
                 "This formula is not always true");
 
+  sequent<list<one_of<int, 1, 3, 7, 12>>, list<between_inclusive<int, 1, 12>>>
+   set_bounds;
+
+  static_assert(truth_value<decltype(set_bounds)>,
+                "Every element of the set is in [1, 12]");
+  static_assert(is_acceptable(7, one_of<int, 1, 3, 7, 12>{}) &&
+                 !is_acceptable(8, one_of<int, 1, 3, 7, 12>{}),
+                "Membership is checked against the set");
+
   constexpr bool val = truth_value<decltype(taut_4)>;
 
+  static_assert(sparse_members(std::make_index_sequence<400>{}),
+                "Sets too sparse for a bitset or a hash are binary searched");
+
+  static_assert(exact_products<std::int8_t, -11, -3>() &&
+                 exact_products<std::int8_t, -7, 0>() &&
+                 exact_products<std::int8_t, -5, 6>() &&
+                 exact_products<std::int8_t, 0, 9>() &&
+                 exact_products<std::int8_t, 4, 11>(),
+                "Products of int8_t intervals are exact for every sign");
+  static_assert(exact_products<std::uint8_t, 0, 0>() &&
+                 exact_products<std::uint8_t, 0, 7>() &&
+                 exact_products<std::uint8_t, 3, 15>() &&
+                 exact_products<std::uint8_t, 10, 15>(),
+                "Products of uint8_t intervals are exact");
+  static_assert(exact_multiplication_checks<std::int8_t>() &&
+                 exact_multiplication_checks<std::uint8_t>(),
+                "Overflow checks are exact for every pair of values");
+  static_assert(exact_product<std::int8_t, -64, -1, 0, 2>() &&
+                 exact_product<std::int8_t, -128, -1, 0, 1>() &&
+                 exact_product<std::int8_t, -127, 127, -1, 1>() &&
+                 exact_product<std::uint8_t, 0, 15, 0, 17>() &&
+                 exact_product<std::uint8_t, 0, 255, 0, 1>(),
+                "Products reaching the limits of the type are accepted");
+  static_assert(!product_accepted<std::int8_t>(-128, -1, -1, 0) &&
+                 !product_accepted<std::int8_t>(-12, 12, -11, 11) &&
+                 !product_accepted<std::uint8_t>(0, 16, 0, 16),
+                "Products past the limits of the type are rejected");
+
   auto s =
    safe<int, and_term<greater<int, 10>, less<int, 20>>>::make_safe<15>();
   auto s2 = make_safe<int, 15>();
@@ -84,6 +198,20 @@ int main() {
     auto c = a - b;
   }
 
+  {
+    // Products of small sets are computed elementwise, while those of large
+    // sets are bounded by the convex hull of their values
+    safe<int, one_of<int, 1, 3, 7, 12>> a = 7;
+    using small = domain<int, decltype(a * a)::constraint>;
+    static_assert(small::cardinality == 10, "Every product is kept");
+
+    auto b = multiples_of_7(std::make_index_sequence<100>{});
+    using large = domain<int, decltype(b * b)::constraint>;
+    static_assert(large::merged.count == 1 && large::lowest == 0 &&
+                   large::highest == 693 * 693,
+                  "Products of 100 by 100 values give one interval");
+  }
+
   // You can use print_type<T> to produce a compile error that will print the
   // full type of T. Uncommenting the following line will print the type of s5
   /// print_type<decltype(s5)> foo;
@@ -98,6 +226,67 @@ int main() {
   // access.
   /// int y = arr[idx2];
 
+  // Reading a counter gives a value in [0, 3], which indexes arr directly; the
+  // only check is the exit condition of the loop.
+  int total = 0;
+  for (auto i : safe_counter<std::size_t, 0, 3>{}) {
+    total += arr[i];
+  }
+
+  // Searches return positions proven to be in range: lower_bound may also
+  // return 4, one past the last element, but max_element always finds one.
+  auto pos = lower_bound(arr, 3);
+  int largest = arr[max_element(arr)];
+
+  // The elements of a lookup table are constrained to its values, so they can
+  // index another table without checks.
+  constexpr auto idx_table = make_lut<std::size_t, 3, 0, 2, 1>();
+  constexpr auto perm_table = make_lut<std::size_t, 7, 5, 6, 4>();
+  std::size_t w = perm_table[idx_table[idx1]];
+  using lut_element = decltype(perm_table)::value_type;
+  static_assert(domain<std::size_t, lut_element::constraint>::cardinality == 4,
+                "Elements of a lookup table only admit its values");
+
+  // Every value admitted by the constraint has an entry in the jump table, so
+  // no range check is needed.
+  safe<int, one_of<int, 1, 3, 7, 12>> opcode = 7;
+  int z = visit(opcode, [](auto op) { return decltype(op)::value * 2; });
+
+  // Narrow values are promoted like the types they wrap, so n3 is an int in
+  // [0, 200], which can be stored back into a byte without checks.
+  safe<std::uint8_t, less_equal<std::uint8_t, 100>> n1 = 40;
+  auto n3 = n1 + n1;
+  safe<std::uint8_t> n4 = n3;
+
+#if __cplusplus >= 202002L
+  // Floating-point values are always finite, and the bounds of arithmetic
+  // results are rounded outwards: g € [-1 - ulp, 2 + ulp]
+  using real = safe<double, between_inclusive<double, -0.5, 1.0>>;
+  real f = 0.25;
+  auto g = f + f;
+  using sum_domain = domain<double, decltype(g)::constraint>;
+  static_assert(sum_domain::lowest == next_down(-1.0) &&
+                 sum_domain::highest == next_up(2.0),
+                "Bounds of a sum are rounded outwards");
+  using product_domain = domain<double, decltype(f * f)::constraint>;
+  static_assert(product_domain::lowest == next_down(-0.5) &&
+                 product_domain::highest == next_up(1.0),
+                "Bounds of a product are rounded outwards");
+  using difference_domain = domain<double, decltype(f - f)::constraint>;
+  static_assert(difference_domain::lowest == next_down(-1.5) &&
+                 difference_domain::highest == next_up(1.5),
+                "Bounds of a difference are rounded outwards");
+
+  using checked = real::checked_constraint;
+  constexpr double inf = std::numeric_limits<double>::infinity();
+  static_assert(is_acceptable(0.25, checked{}) &&
+                 !is_acceptable(std::numeric_limits<double>::quiet_NaN(),
+                                checked{}) &&
+                 !is_acceptable(inf, checked{}) &&
+                 !is_acceptable(-inf, checked{}),
+                "NaN and infinities are never stored");
+#endif
+
   return val ? 0 : 1;
   return 0;
 }
\ No newline at end of file
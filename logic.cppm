@@ -0,0 +1,41 @@
+// C++20 module interface for the library
+/*
+ Exports every entity declared by `logic_all.hpp`. Every standard header used
+ by the library is included in the global module fragment, and the headers of
+ the library are included in an `export` block, so that their declarations
+ are attached to the module. Macros such as `LOGIC_CHECK_ASSUMPTIONS` must
+ therefore be defined when the module itself is compiled. `logic_import.cpp`
+ imports it, e.g. with GCC:
+
+    g++ -std=c++20 -fmodules-ts -x c++ -c logic.cppm -o logic_module.o
+    g++ -std=c++20 -fmodules-ts logic_import.cpp logic_module.o
+*/
+module;
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#if __has_include(<bit>)
+#include <bit>
+#endif
+export module logic;
+
+export {
+#include "logic_all.hpp"
+}
+
+// Specializations shared by most importers, instantiated once in the module
+namespace logic {
+  template class safe<int>;
+  template class safe<unsigned>;
+  template class safe<long>;
+  template class safe<unsigned long>;
+  template class safe<long long>;
+  template class safe<unsigned long long>;
+} // namespace logic
@@ -1,8 +1,16 @@
 #ifndef LOGIC_HPP
 #define LOGIC_HPP
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
 #include <type_traits>
 
+#if __has_include(<bit>)
+#include <bit>
+#endif
+
 namespace logic {
   // Nonterminal terms
   /*
@@ -67,6 +75,26 @@ namespace logic {
      typename and_term<less_equal<T, Max>, greater_equal<T, Min>>::type;
   };
 
+  // Values that are neither NaN nor infinite, for floating-point types
+  template <typename T> struct finite {
+    using type =
+     typename between_inclusive<T, std::numeric_limits<T>::lowest(),
+                                std::numeric_limits<T>::max()>::type;
+  };
+
+  /*
+   `one_of` restricts a value to a finite set of values. For the purposes of
+   the inference rules it is the disjunction of the singleton intervals
+
+      or_term<between_inclusive<T, V1, V1>, between_inclusive<T, V2, V2>, ...>
+
+   so arithmetic on it is carried out element by element. Runtime checks do
+   not go through the disjunction, see `value_set` below.
+  */
+  template <typename T, T... Vs> struct one_of {
+    using type = typename or_term<between_inclusive<T, Vs, Vs>...>::type;
+  };
+
   // Inference rules
   /*
    Implementation of the rules specified in section 2.2 of the thesis
@@ -283,22 +311,70 @@ namespace logic {
            list<typename T::type, typename Cs::type...>>::value;
   };
 
+  // Replaces short-hand terms at the top level of a sequent, so that sequents
+  // such as `sequent<list<one_of<...>>, list<between<...>>>` can be proven
+  template <typename T> struct expand_sequent;
+  template <typename... Ls, typename... Rs>
+  struct expand_sequent<sequent<list<Ls...>, list<Rs...>>> {
+    using type =
+     sequent<list<typename Ls::type...>, list<typename Rs::type...>>;
+  };
   template <typename T>
-  constexpr bool truth_value = proof<list<>, T, list<>>::value;
+  using expand_sequent_t = typename expand_sequent<T>::type;
+
+  template <typename T>
+  constexpr bool truth_value =
+   proof<list<>, expand_sequent_t<T>, list<>>::value;
+
+  /*
+   Negations are pushed down to the terminal terms instead of negating the
+   result of a check: every comparison with NaN is false, so `!(x < 10.0)`
+   would accept NaN while `x >= 10.0` rejects it like any other terminal does.
+
+   `and` and `or` terms evaluate all of their operands without short-circuits,
+   so that checks compile to branchless code that can be vectorized, see
+   `find_unacceptable`. This matters for floating-point comparisons, which
+   compilers do not evaluate speculatively.
+  */
+  template <typename T, T Constr>
+  constexpr bool is_acceptable(T Value, not_term<less<T, Constr>> c) {
+    return Value >= Constr;
+  }
+
+  template <typename T, T Constr>
+  constexpr bool is_acceptable(T Value, not_term<less_equal<T, Constr>> c) {
+    return Value > Constr;
+  }
 
   template <typename T, typename C>
+  constexpr bool is_acceptable(T Value, not_term<not_term<C>> c) {
+    return is_acceptable(Value, C{});
+  }
+
+  template <typename T, typename... Cs>
+  constexpr bool is_acceptable(T Value, not_term<and_term<Cs...>> c) {
+    return (false | ... | is_acceptable(Value, not_term<Cs>{}));
+  }
+
+  template <typename T, typename... Cs>
+  constexpr bool is_acceptable(T Value, not_term<or_term<Cs...>> c) {
+    return (true & ... & is_acceptable(Value, not_term<Cs>{}));
+  }
+
+  template <typename T, typename C,
+            typename = std::enable_if_t<!std::is_same_v<typename C::type, C>>>
   constexpr bool is_acceptable(T Value, not_term<C> c) {
-    return !(is_acceptable(Value, typename C::type{}));
+    return is_acceptable(Value, not_term<typename C::type>{});
   }
 
   template <typename T, typename... Cs>
   constexpr bool is_acceptable(T Value, and_term<Cs...> c) {
-    return (is_acceptable(Value, typename Cs::type{}) && ...);
+    return (true & ... & is_acceptable(Value, Cs{}));
   }
 
   template <typename T, typename... Cs>
   constexpr bool is_acceptable(T Value, or_term<Cs...> c) {
-    return (is_acceptable(Value, typename Cs::type{}) || ...);
+    return (false | ... | is_acceptable(Value, Cs{}));
   }
 
   template <typename T, T Constr>
@@ -311,11 +387,340 @@ namespace logic {
     return Value <= Constr;
   }
 
+  // Short-hand terms are checked through the constraint they stand for
+  template <typename T, typename C,
+            typename = std::enable_if_t<!std::is_same_v<typename C::type, C>>>
+  constexpr bool is_acceptable(T Value, C c) {
+    return is_acceptable(Value, typename C::type{});
+  }
+
+  // Membership tests for `one_of`
+  /*
+   Checking a `one_of` through its disjunction would compare the value against
+   every element of the set. `value_lookup` instead picks, at compile time, one
+   of three lookup strategies:
+    1. If the values span less than `DenseSpan` integers, a bitset indexed by
+       `value - lowest` is used: one bound check and one bit test.
+    2. Otherwise a multiplicative hash `(key * multiplier) >> (64 - bits)`
+       without collisions over the set is searched for, with tables of at most
+       16 slots per element. Membership is a single comparison against the only
+       value that can occupy the slot.
+    3. If no such hash is found, the values are sorted and binary searched.
+
+   `value_set` is the lookup used for membership checks, where a bitset is
+   cheap enough for any set spanning less than 4096 integers.
+  */
+  constexpr std::uint64_t hash_multiplier(std::uint64_t seed) {
+    std::uint64_t z = (seed + 1) * 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return (z ^ (z >> 31)) | 1;
+  }
+
+  constexpr unsigned ceil_log2(std::size_t n) {
+    unsigned res = 0;
+    while ((std::size_t{1} << res) < n) {
+      ++res;
+    }
+    return res;
+  }
+
+  template <std::uint64_t DenseSpan, typename T, T... Vs> struct value_lookup {
+    static_assert(sizeof...(Vs) > 0, "Empty value set");
+    static_assert(std::is_integral_v<T> && !std::is_same_v<T, bool>,
+                  "Value sets must be made of integers");
+
+    using key_type = std::make_unsigned_t<T>;
+    static constexpr std::size_t size = sizeof...(Vs);
+    static constexpr T values[size] = {Vs...};
+
+    static constexpr T find_lowest() {
+      T res = values[0];
+      for (auto v : values) {
+        res = v < res ? v : res;
+      }
+      return res;
+    }
+    static constexpr T find_highest() {
+      T res = values[0];
+      for (auto v : values) {
+        res = v > res ? v : res;
+      }
+      return res;
+    }
+    static constexpr T lowest = find_lowest();
+    static constexpr T highest = find_highest();
+
+    static constexpr std::uint64_t key(T v) {
+      return static_cast<key_type>(v);
+    }
+    static constexpr std::uint64_t offset(T v) {
+      return static_cast<key_type>(static_cast<key_type>(v) -
+                                   static_cast<key_type>(lowest));
+    }
+
+    static constexpr std::uint64_t span = offset(highest);
+    static constexpr bool is_dense = span < DenseSpan;
+
+    using bitset = std::array<std::uint64_t, is_dense ? span / 64 + 1 : 1>;
+    static constexpr bitset make_bitset() {
+      bitset res{};
+      if (is_dense) {
+        for (auto v : values) {
+          res[offset(v) / 64] |= std::uint64_t{1} << (offset(v) % 64);
+        }
+      }
+      return res;
+    }
+    static constexpr bitset bits = make_bitset();
+
+    static constexpr unsigned min_hash_bits = ceil_log2(size) + 1;
+    static constexpr unsigned max_hash_bits = min_hash_bits + 3;
+    static constexpr std::size_t hash_attempts = 256;
+    // Slots written during the search for a hash, which keeps it within the
+    // limits of constant evaluation. Large sets give up early and are sorted.
+    static constexpr std::size_t hash_budget = std::size_t{1} << 16;
+
+    struct hash_params {
+      std::uint64_t multiplier;
+      unsigned bits;
+    };
+    static constexpr std::size_t slot(T v, hash_params h) {
+      return static_cast<std::size_t>((key(v) * h.multiplier) >> (64 - h.bits));
+    }
+    static constexpr hash_params find_hash() {
+      constexpr std::size_t slots = std::size_t{1} << max_hash_bits;
+      if (is_dense || slots > hash_budget) {
+        return {0, 0};
+      }
+      // Slots hold the number of the last attempt that used them, so that the
+      // table is only cleared once
+      std::array<std::size_t, (is_dense ? 1 : slots)> used{};
+      std::size_t attempt = 0;
+      std::size_t work = slots;
+      for (unsigned bits = min_hash_bits; bits <= max_hash_bits; ++bits) {
+        for (std::size_t i = 0; i < hash_attempts && work < hash_budget; ++i) {
+          hash_params h{hash_multiplier(i), bits};
+          ++attempt;
+          std::size_t placed = 0;
+          for (; placed < size; ++placed) {
+            auto s = slot(values[placed], h);
+            if (used[s] == attempt) {
+              break;
+            }
+            used[s] = attempt;
+          }
+          if (placed == size) {
+            return h;
+          }
+          work += placed + 1;
+        }
+      }
+      return {0, 0};
+    }
+    static constexpr hash_params hash = find_hash();
+    static constexpr bool is_hashed = hash.bits != 0;
+
+    /*
+     Empty slots hold `values[0]`: a value hashing to an empty slot cannot be
+     `values[0]`, which has a slot of its own, so the comparison fails.
+    */
+    using hash_table =
+     std::array<T, is_hashed ? (std::size_t{1} << hash.bits) : 1>;
+    static constexpr hash_table make_hash_table() {
+      hash_table res{};
+      for (auto &v : res) {
+        v = values[0];
+      }
+      if (is_hashed) {
+        for (auto v : values) {
+          res[slot(v, hash)] = v;
+        }
+      }
+      return res;
+    }
+    static constexpr hash_table table = make_hash_table();
+
+    using sorted_table =
+     std::array<T, !is_dense && !is_hashed ? size : std::size_t{1}>;
+    // Heapsort, so that large sets stay within the limits of constant
+    // evaluation
+    static constexpr void sift_down(sorted_table &heap, std::size_t root,
+                                    std::size_t end) {
+      for (std::size_t child = 2 * root + 1; child < end;
+           root = child, child = 2 * root + 1) {
+        if (child + 1 < end && heap[child] < heap[child + 1]) {
+          ++child;
+        }
+        if (!(heap[root] < heap[child])) {
+          return;
+        }
+        T tmp = heap[root];
+        heap[root] = heap[child];
+        heap[child] = tmp;
+      }
+    }
+    static constexpr sorted_table make_sorted() {
+      sorted_table res{};
+      if (!is_dense && !is_hashed) {
+        for (std::size_t i = 0; i < size; ++i) {
+          res[i] = values[i];
+        }
+        for (std::size_t i = size / 2; i > 0; --i) {
+          sift_down(res, i - 1, size);
+        }
+        for (std::size_t end = size - 1; end > 0; --end) {
+          T tmp = res[0];
+          res[0] = res[end];
+          res[end] = tmp;
+          sift_down(res, 0, end);
+        }
+      }
+      return res;
+    }
+    static constexpr sorted_table sorted = make_sorted();
+
+    // Tables indexed by `index` need `index_size` entries. For members of the
+    // set the index is unique; other values may share it with a member.
+    static constexpr std::size_t index_size =
+     is_dense ? span + 1 : is_hashed ? hash_table{}.size() : size;
+
+    static constexpr std::size_t index(T v) {
+      if constexpr (is_dense) {
+        return offset(v);
+      } else if constexpr (is_hashed) {
+        return slot(v, hash);
+      } else {
+        const T *base = sorted.data();
+        for (std::size_t n = size; n > 1; n -= n / 2) {
+          base = base[n / 2] <= v ? base + n / 2 : base;
+        }
+        return base - sorted.data();
+      }
+    }
+
+    static constexpr bool contains(T v) {
+      auto idx = index(v);
+      if constexpr (is_dense) {
+        return idx <= span && ((bits[idx / 64] >> (idx % 64)) & 1);
+      } else if constexpr (is_hashed) {
+        return table[idx] == v;
+      } else {
+        return sorted[idx] == v;
+      }
+    }
+
+    // Inverse of `index`, for building tables
+    static constexpr bool has_member(std::size_t idx) {
+      if constexpr (is_dense) {
+        return (bits[idx / 64] >> (idx % 64)) & 1;
+      } else if constexpr (is_hashed) {
+        return slot(table[idx], hash) == idx;
+      } else {
+        return true;
+      }
+    }
+    static constexpr T member(std::size_t idx) {
+      if constexpr (is_dense) {
+        return static_cast<T>(static_cast<key_type>(lowest) + idx);
+      } else if constexpr (is_hashed) {
+        return table[idx];
+      } else {
+        return sorted[idx];
+      }
+    }
+  };
+
+  template <typename T, T... Vs>
+  using value_set = value_lookup<4096, T, Vs...>;
+
+  template <typename T, T... Vs>
+  constexpr bool is_acceptable(T Value, one_of<T, Vs...> c) {
+    if constexpr (std::is_integral_v<T>) {
+      return value_set<T, Vs...>::contains(Value);
+    } else {
+      return (false | ... | (Value == Vs));
+    }
+  }
+
+  // Bulk validation
+  /*
+   Returns the position of the first of the `count` values at `first` that is
+   not acceptable for `C`, or `count` if all of them are. Values are checked in
+   blocks without early exits so that the compiler can vectorize the checks;
+   only the block containing a failure is scanned again element by element.
+  */
+  template <typename C, typename T>
+  constexpr std::size_t find_unacceptable(const T *first, std::size_t count) {
+    constexpr std::size_t block = 64;
+    std::size_t i = 0;
+    for (; i + block <= count; i += block) {
+      std::size_t rejected = 0;
+      for (std::size_t j = 0; j < block; ++j) {
+        rejected |= !is_acceptable(first[i + j], C{});
+      }
+      if (rejected) {
+        break;
+      }
+    }
+    for (; i < count; ++i) {
+      if (!is_acceptable(first[i], C{})) {
+        return i;
+      }
+    }
+    return count;
+  }
+
+  // Adjacent values
+  /*
+   `next_up(v)` is the smallest value of `T` greater than `v` and `next_down(v)`
+   the largest one less than `v`: `v + 1` and `v - 1` for integers, the
+   neighbouring representable values for IEEE 754 `float` and `double`.
+   Callers make sure that the result exists.
+  */
+  template <typename To, typename From> constexpr To bitwise_cast(From v) {
+#if defined(__cpp_lib_bit_cast)
+    return std::bit_cast<To>(v);
+#else
+    return __builtin_bit_cast(To, v);
+#endif
+  }
+
+  template <typename T> constexpr T next_up(T v) {
+    if constexpr (std::is_integral_v<T>) {
+      return static_cast<T>(v + 1);
+    } else {
+      static_assert(std::numeric_limits<T>::is_iec559 &&
+                     (sizeof(T) == 4 || sizeof(T) == 8),
+                    "Unsupported floating-point type");
+      using bits_type =
+       std::conditional_t<sizeof(T) == 4, std::uint32_t, std::uint64_t>;
+      if (v != v || v == std::numeric_limits<T>::infinity()) {
+        return v;
+      } else if (v == 0) {
+        return std::numeric_limits<T>::denorm_min();
+      }
+      auto bits = bitwise_cast<bits_type>(v);
+      bits = v > 0 ? bits + 1 : bits - 1;
+      return bitwise_cast<T>(bits);
+    }
+  }
+
+  template <typename T> constexpr T next_down(T v) {
+    if constexpr (std::is_integral_v<T>) {
+      return static_cast<T>(v - 1);
+    } else {
+      return -next_up(-v);
+    }
+  }
+
+  template <typename T> constexpr T min(T a) { return a; }
   template <typename T> constexpr T min(T a, T b) { return a < b ? a : b; }
   template <typename T, typename... Ts> constexpr T min(T a, Ts... b) {
     return min(a, min(b...));
   }
 
+  template <typename T> constexpr T max(T a) { return a; }
   template <typename T> constexpr T max(T a, T b) { return a > b ? a : b; }
   template <typename T, typename... Ts> constexpr T max(T a, Ts... b) {
     return max(a, max(b...));
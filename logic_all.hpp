@@ -0,0 +1,63 @@
+#ifndef LOGIC_ALL_HPP
+#define LOGIC_ALL_HPP
+/*
+ Umbrella header for the library, suitable as a precompiled header: it pulls
+ in the standard headers used by the library first, then all of the headers
+ that do not depend on the platform (`safe_column.hpp` needs POSIX and
+ `safe_parallel.hpp` needs threads, include them separately).
+
+ Defining `LOGIC_EXTERN_TEMPLATES` declares the specializations explicitly
+ instantiated in `logic_instantiations.cpp` as `extern`, so that translation
+ units linked against it do not instantiate them again.
+*/
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "logic.hpp"
+#include "safe.hpp"
+#include "safe_algorithm.hpp"
+#include "safe_array.hpp"
+#include "safe_counter.hpp"
+#include "safe_dispatch.hpp"
+
+#if defined(LOGIC_EXTERN_TEMPLATES) || defined(LOGIC_INSTANTIATE_TEMPLATES)
+#ifdef LOGIC_INSTANTIATE_TEMPLATES
+#define LOGIC_EXTERN
+#else
+#define LOGIC_EXTERN extern
+#endif
+
+// Specializations every `safe` over a built-in integer type needs
+#define LOGIC_INSTANTIATE(T)                                                   \
+  LOGIC_EXTERN template class safe<T>;                                         \
+  LOGIC_EXTERN template struct normalize<T, safe<T>::constraint::type>;        \
+  LOGIC_EXTERN template bool is_acceptable(T, safe<T>::constraint);            \
+  LOGIC_EXTERN template struct domain_of<                                      \
+   T, normalize_t<T, safe<T>::constraint::type>>;
+
+namespace logic {
+  LOGIC_INSTANTIATE(signed char)
+  LOGIC_INSTANTIATE(unsigned char)
+  LOGIC_INSTANTIATE(short)
+  LOGIC_INSTANTIATE(unsigned short)
+  LOGIC_INSTANTIATE(int)
+  LOGIC_INSTANTIATE(unsigned)
+  LOGIC_INSTANTIATE(long)
+  LOGIC_INSTANTIATE(unsigned long)
+  LOGIC_INSTANTIATE(long long)
+  LOGIC_INSTANTIATE(unsigned long long)
+} // namespace logic
+
+#undef LOGIC_INSTANTIATE
+#undef LOGIC_EXTERN
+#endif
+
+#endif
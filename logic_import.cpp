@@ -0,0 +1,40 @@
+// Uses the library through the `logic` module, see `logic.cppm`. The module
+// does not export the standard library, which is included as usual.
+#include <cstddef>
+#include <stdexcept>
+import logic;
+
+using namespace logic;
+
+int main() {
+  static_assert(truth_value<sequent<list<less<int, 1>>, list<less<int, 2>>>>,
+                "Proofs are available to importers");
+
+  safe<int, between_inclusive<int, 0, 10>> a = 2;
+  auto b = make_safe<int, 3>();
+  auto c = a * b + b;
+
+  safe_array<int, 4> arr{1, 2, 3, 4};
+  int total = 0;
+  for (auto i : safe_counter<std::size_t, 0, 3>{}) {
+    total += arr[i];
+  }
+  int largest = arr[max_element(arr)];
+
+  constexpr auto perm = make_lut<std::size_t, 3, 0, 2, 1>();
+  auto index = make_safe<std::size_t, 2>();
+  safe<int, one_of<int, 1, 3, 7>> opcode = 7;
+  int twice = visit(opcode, [](auto op) { return decltype(op)::value * 2; });
+
+  bool rejected = false;
+  try {
+    safe<int, between_inclusive<int, 0, 10>> d = 11;
+  } catch (const std::range_error &) {
+    rejected = true;
+  }
+
+  return int(c) == 9 && total == 10 && largest == 4 && perm[perm[index]] == 2 &&
+                 twice == 14 && rejected
+          ? 0
+          : 1;
+}
@@ -0,0 +1,4 @@
+// Explicit instantiations of the specializations declared by `logic_all.hpp`
+// when `LOGIC_EXTERN_TEMPLATES` is defined
+#define LOGIC_INSTANTIATE_TEMPLATES
+#include "logic_all.hpp"
@@ -2,21 +2,79 @@
 #define SAFE_HPP
 
 #include "logic.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
 #include <limits>
 #include <optional>
 #include <stdexcept>
 #include <type_traits>
+#include <utility>
+
+#ifdef LOGIC_INSTRUMENT
+#include "safe_instrument.hpp"
+#endif
 
 namespace logic {
+  // Floating-point results must stay finite after `outward` widens them
+  template <typename T> constexpr bool is_finite_result(T res) {
+    return std::numeric_limits<T>::lowest() < res &&
+           res < std::numeric_limits<T>::max();
+  }
+
   template <typename T> constexpr bool is_addition_safe(T lhs, T rhs) {
-    if (lhs >= 0 && rhs >= 0) {
-      return std::numeric_limits<T>::max() - lhs > rhs;
+    if constexpr (std::is_floating_point_v<T>) {
+      return is_finite_result(lhs + rhs);
+    } else if (lhs >= 0 && rhs >= 0) {
+      return std::numeric_limits<T>::max() - lhs >= rhs;
     } else if (lhs < 0 && rhs < 0) {
-      return lhs > std::numeric_limits<T>::lowest() - rhs;
+      return lhs >= std::numeric_limits<T>::lowest() - rhs;
     }
     return true;
   }
 
+  // Outward rounding
+  /*
+   Floating-point bounds computed by `sum`, `sub` and `prod` are rounded to
+   nearest. The operations at runtime may round differently: `a * b + c` can
+   be contracted into a fused multiply-add, or evaluated with extra precision.
+   Widening every bound by one ulp and making it inclusive keeps it valid
+   whatever the rounding of the operations. Integer bounds are left untouched.
+  */
+  template <typename C, typename Enable = void> struct outward {
+    using type = C;
+  };
+  template <typename C> using outward_t = typename outward<C>::type;
+
+  template <typename... Cs> struct outward<and_term<Cs...>> {
+    using type = and_term<outward_t<Cs>...>;
+  };
+
+  template <typename T, T Value>
+  struct outward<less<T, Value>,
+                 std::enable_if_t<std::is_floating_point_v<T>>> {
+    using type = less_equal<T, next_up(Value)>;
+  };
+
+  template <typename T, T Value>
+  struct outward<less_equal<T, Value>,
+                 std::enable_if_t<std::is_floating_point_v<T>>> {
+    using type = less_equal<T, next_up(Value)>;
+  };
+
+  template <typename T, T Value>
+  struct outward<not_term<less<T, Value>>,
+                 std::enable_if_t<std::is_floating_point_v<T>>> {
+    using type = not_term<less<T, next_down(Value)>>;
+  };
+
+  template <typename T, T Value>
+  struct outward<not_term<less_equal<T, Value>>,
+                 std::enable_if_t<std::is_floating_point_v<T>>> {
+    using type = not_term<less<T, next_down(Value)>>;
+  };
+
   template <typename A, typename B> struct sum;
   template <typename A, typename B> using sum_t = typename sum<A, B>::type;
 
@@ -70,7 +128,7 @@ namespace logic {
 
   template <typename L1, typename L2, typename R1, typename R2>
   struct sum<and_term<L1, L2>, and_term<R1, R2>> {
-    using type = and_term<sum_t<L1, R1>, sum_t<L2, R2>>;
+    using type = outward_t<and_term<sum_t<L1, R1>, sum_t<L2, R2>>>;
   };
 
   template <typename T1, typename T2> struct normalize {
@@ -94,6 +152,192 @@ namespace logic {
   template <typename T1, typename T2>
   using normalize_t = typename normalize<T1, T2>::type;
 
+  // Inclusive bounds of the intervals produced by `normalize`
+  /*
+   `exists` is false when the bound cannot be made inclusive, e.g. `x < lowest`,
+   in which case the interval is empty.
+  */
+  template <typename T> struct inclusive_bound;
+  template <typename T, T Value> struct inclusive_bound<less<T, Value>> {
+    static constexpr bool exists = Value != std::numeric_limits<T>::lowest();
+    static constexpr T value = exists ? next_down(Value) : Value;
+  };
+  template <typename T, T Value> struct inclusive_bound<less_equal<T, Value>> {
+    static constexpr bool exists = true;
+    static constexpr T value = Value;
+  };
+  template <typename T, T Value>
+  struct inclusive_bound<not_term<less<T, Value>>> {
+    static constexpr bool exists = true;
+    static constexpr T value = Value;
+  };
+  template <typename T, T Value>
+  struct inclusive_bound<not_term<less_equal<T, Value>>> {
+    static constexpr bool exists = Value != std::numeric_limits<T>::max();
+    static constexpr T value = exists ? next_up(Value) : Value;
+  };
+
+  template <typename T> struct interval {
+    T lowest;
+    T highest;
+    bool empty;
+  };
+
+  template <typename T> struct interval_of;
+  template <typename U, typename L>
+  struct interval_of<and_term<U, not_term<L>>> {
+    using upper = inclusive_bound<U>;
+    using lower = inclusive_bound<not_term<L>>;
+    using value_type = std::remove_const_t<decltype(upper::value)>;
+    static constexpr interval<value_type> value = {
+     lower::value, upper::value,
+     !upper::exists || !lower::exists || upper::value < lower::value};
+  };
+
+  // The set of values admitted by a constraint, as a list of intervals
+  template <typename T, typename N> struct domain_of;
+  template <typename T, typename... Is> struct domain_of<T, or_term<Is...>> {
+    static constexpr std::size_t size = sizeof...(Is);
+    static constexpr interval<T> intervals[size] = {interval_of<Is>::value...};
+    static constexpr bool empty = (interval_of<Is>::value.empty && ...);
+
+    static constexpr T find_lowest() {
+      T res = std::numeric_limits<T>::max();
+      for (auto i : intervals) {
+        res = !i.empty && i.lowest < res ? i.lowest : res;
+      }
+      return res;
+    }
+    static constexpr T find_highest() {
+      T res = std::numeric_limits<T>::lowest();
+      for (auto i : intervals) {
+        res = !i.empty && i.highest > res ? i.highest : res;
+      }
+      return res;
+    }
+    // Convex hull of the intervals
+    static constexpr T lowest = find_lowest();
+    static constexpr T highest = find_highest();
+
+    static constexpr bool contains(T v) {
+      for (auto i : intervals) {
+        if (!i.empty && i.lowest <= v && v <= i.highest) {
+          return true;
+        }
+      }
+      return false;
+    }
+
+    // Non-empty intervals, sorted and with overlapping or adjacent ones merged
+    struct merged_intervals {
+      interval<T> values[size];
+      std::size_t count;
+    };
+    static constexpr merged_intervals merge() {
+      merged_intervals res{};
+      for (auto i : intervals) {
+        if (i.empty) {
+          continue;
+        }
+        std::size_t j = res.count++;
+        for (; j > 0 && i.lowest < res.values[j - 1].lowest; --j) {
+          res.values[j] = res.values[j - 1];
+        }
+        res.values[j] = i;
+      }
+      std::size_t count = 0;
+      for (std::size_t j = 0; j < res.count; ++j) {
+        auto i = res.values[j];
+        auto &last = res.values[count > 0 ? count - 1 : 0];
+        if (count > 0 &&
+            (i.lowest <= last.highest ||
+             (last.highest != std::numeric_limits<T>::max() &&
+              next_up(last.highest) == i.lowest))) {
+          last.highest = i.highest > last.highest ? i.highest : last.highest;
+        } else {
+          res.values[count++] = i;
+        }
+      }
+      res.count = count;
+      return res;
+    }
+    static constexpr merged_intervals merged = merge();
+
+    // Number of admitted values, saturated to the largest `std::uint64_t`.
+    // Floating-point domains are not counted and always saturate.
+    static constexpr std::uint64_t find_cardinality() {
+      if constexpr (std::is_floating_point_v<T>) {
+        return std::numeric_limits<std::uint64_t>::max();
+      } else {
+        return count_integers();
+      }
+    }
+    static constexpr std::uint64_t count_integers() {
+      using U = std::make_unsigned_t<T>;
+      std::uint64_t res = 0;
+      for (std::size_t j = 0; j < merged.count; ++j) {
+        auto i = merged.values[j];
+        std::uint64_t n = static_cast<U>(static_cast<U>(i.highest) -
+                                         static_cast<U>(i.lowest));
+        if (n == std::numeric_limits<std::uint64_t>::max() ||
+            res > std::numeric_limits<std::uint64_t>::max() - n - 1) {
+          return std::numeric_limits<std::uint64_t>::max();
+        }
+        res += n + 1;
+      }
+      return res;
+    }
+    static constexpr std::uint64_t cardinality = find_cardinality();
+
+    // The first `N` admitted values, in increasing order
+    template <std::size_t N> static constexpr std::array<T, N> members() {
+      std::array<T, N> res{};
+      std::size_t k = 0;
+      for (std::size_t j = 0; j < merged.count && k < N; ++j) {
+        for (T v = merged.values[j].lowest; k < N; v = next_up(v)) {
+          res[k++] = v;
+          if (v == merged.values[j].highest) {
+            break;
+          }
+        }
+      }
+      return res;
+    }
+  };
+
+  template <typename T, typename C>
+  using domain = domain_of<T, normalize_t<T, typename C::type>>;
+
+  // Operands of arithmetic
+  /*
+   Results are computed for every pair of intervals of the operands, so that
+   small sets of values such as those of `one_of` map elementwise. Above
+   `max_result_intervals` pairs, each operand is replaced by its convex hull
+   instead, which keeps the result to a single interval.
+  */
+  inline constexpr std::size_t max_result_intervals = 64;
+
+  template <typename T, typename N, bool Hull> struct hull_if {
+    using type = N;
+  };
+  template <typename T, typename... Is>
+  struct hull_if<T, or_term<Is...>, true> {
+    using dom = domain_of<T, or_term<Is...>>;
+    using type = std::conditional_t<
+     dom::empty, or_term<Is...>,
+     or_term<and_term<less_equal<T, dom::highest>,
+                      not_term<less<T, dom::lowest>>>>>;
+  };
+
+  template <typename T, typename N1, typename N2> struct operands;
+  template <typename T, typename... I1s, typename... I2s>
+  struct operands<T, or_term<I1s...>, or_term<I2s...>> {
+    static constexpr bool hull =
+     sizeof...(I1s) * sizeof...(I2s) > max_result_intervals;
+    using lhs = typename hull_if<T, or_term<I1s...>, hull>::type;
+    using rhs = typename hull_if<T, or_term<I2s...>, hull>::type;
+  };
+
   template <typename C1, typename C2> struct sum_type;
   template <typename C1, typename C2>
   using sum_type_t = typename sum_type<C1, C2>::type;
@@ -110,7 +354,11 @@ namespace logic {
   };
 
   template <typename T> constexpr bool is_subtraction_safe(T lhs, T rhs) {
-    if (lhs >= 0 && rhs < 0) {
+    if constexpr (std::is_floating_point_v<T>) {
+      return is_finite_result(lhs - rhs);
+    } else if constexpr (std::is_unsigned_v<T>) {
+      return lhs >= rhs;
+    } else if (lhs >= 0 && rhs < 0) {
       return std::numeric_limits<T>::max() + rhs >= lhs;
     } else if (lhs < 0 && rhs >= 0) {
       return std::numeric_limits<T>::lowest() + rhs <= lhs;
@@ -118,60 +366,65 @@ namespace logic {
     return true;
   }
 
+  /*
+   The upper bound of `x - y` is the upper bound of `x` minus the lower bound
+   of `y`, and its lower bound is the lower bound of `x` minus the upper bound
+   of `y`. The result is strict whenever one of the two bounds is.
+  */
   template <typename A, typename B> struct sub;
   template <typename A, typename B> using sub_t = typename sub<A, B>::type;
 
   template <typename T, T Value1, T Value2>
-  struct sub<less<T, Value1>, less<T, Value2>> {
+  struct sub<less<T, Value1>, not_term<less<T, Value2>>> {
     static_assert(is_subtraction_safe(Value1, Value2), "Overflow detected");
     using type = less<T, Value1 - Value2>;
   };
 
   template <typename T, T Value1, T Value2>
-  struct sub<less_equal<T, Value1>, less<T, Value2>> {
+  struct sub<less_equal<T, Value1>, not_term<less<T, Value2>>> {
     static_assert(is_subtraction_safe(Value1, Value2), "Overflow detected");
-    using type = less<T, Value1 - Value2>;
+    using type = less_equal<T, Value1 - Value2>;
   };
 
   template <typename T, T Value1, T Value2>
-  struct sub<less<T, Value1>, less_equal<T, Value2>> {
+  struct sub<less<T, Value1>, not_term<less_equal<T, Value2>>> {
     static_assert(is_subtraction_safe(Value1, Value2), "Overflow detected");
     using type = less<T, Value1 - Value2>;
   };
 
   template <typename T, T Value1, T Value2>
-  struct sub<less_equal<T, Value1>, less_equal<T, Value2>> {
+  struct sub<less_equal<T, Value1>, not_term<less_equal<T, Value2>>> {
     static_assert(is_subtraction_safe(Value1, Value2), "Overflow detected");
-    using type = less_equal<T, Value1 - Value2>;
+    using type = less<T, Value1 - Value2>;
   };
 
   template <typename T, T Value1, T Value2>
-  struct sub<not_term<less<T, Value1>>, not_term<less<T, Value2>>> {
+  struct sub<not_term<less<T, Value1>>, less_equal<T, Value2>> {
     static_assert(is_subtraction_safe(Value1, Value2), "Overflow detected");
     using type = not_term<less<T, Value1 - Value2>>;
   };
 
   template <typename T, T Value1, T Value2>
-  struct sub<not_term<less_equal<T, Value1>>, not_term<less<T, Value2>>> {
+  struct sub<not_term<less_equal<T, Value1>>, less_equal<T, Value2>> {
     static_assert(is_subtraction_safe(Value1, Value2), "Overflow detected");
     using type = not_term<less_equal<T, Value1 - Value2>>;
   };
 
   template <typename T, T Value1, T Value2>
-  struct sub<not_term<less<T, Value1>>, not_term<less_equal<T, Value2>>> {
+  struct sub<not_term<less<T, Value1>>, less<T, Value2>> {
     static_assert(is_subtraction_safe(Value1, Value2), "Overflow detected");
     using type = not_term<less_equal<T, Value1 - Value2>>;
   };
 
   template <typename T, T Value1, T Value2>
-  struct sub<not_term<less_equal<T, Value1>>, not_term<less_equal<T, Value2>>> {
+  struct sub<not_term<less_equal<T, Value1>>, less<T, Value2>> {
     static_assert(is_subtraction_safe(Value1, Value2), "Overflow detected");
     using type = not_term<less_equal<T, Value1 - Value2>>;
   };
 
   template <typename L1, typename L2, typename R1, typename R2>
   struct sub<and_term<L1, L2>, and_term<R1, R2>> {
-    using type = and_term<sub_t<L1, R1>, sub_t<L2, R2>>;
+    using type = outward_t<and_term<sub_t<L1, R2>, sub_t<L2, R1>>>;
   };
 
   template <typename C1, typename C2> struct sub_type;
@@ -189,165 +442,75 @@ namespace logic {
                           sub_type_t<or_term<T1s...>, or_term<T2s...>>>;
   };
 
-  template <typename T> constexpr std::size_t constlog2(T v) {
-    if (v < 0) {
-      return 1 + constlog2(-(v / 2));
-    } else if (v == 0) {
-      return 0;
-    } else {
-      return 1 + constlog2(v / 2);
-    }
-  }
-
-  // Implementation of v overline
-  template <typename T> struct invert;
-  template <typename T, T Value> struct invert<less<T, Value>> {
-    using type = less_equal<T, Value>;
-  };
-  template <typename T, T Value> struct invert<less_equal<T, Value>> {
-    using type = less<T, Value>;
-  };
-  template <typename T> using invert_t = typename invert<T>::type;
-
-  // Implementation of epsilon
-  template <typename T> struct bound_value_s;
-  template <typename T, T Value> struct bound_value_s<less<T, Value>> {
-    static constexpr T value = Value;
-  };
-  template <typename T, T Value> struct bound_value_s<less_equal<T, Value>> {
-    static constexpr T value = Value;
-  };
-
-  template <typename T> constexpr auto bound_value = bound_value_s<T>::value;
-
-  template <typename T1, typename T2> struct cmax {
-    using type = std::conditional_t<(bound_value<T1>> bound_value<T2>), T1, T2>;
-  };
-  template <typename T1, typename T2>
-  using cmax_t = typename cmax<T1, T2>::type;
-
-  template <typename T1, typename T2> struct cmin {
-    using type =
-     std::conditional_t<(bound_value<T1> < bound_value<T2>), T1, T2>;
-  };
-  template <typename T1, typename T2>
-  using cmin_t = typename cmin<T1, T2>::type;
-
+  // Exact overflow check, following CERT INT32-C
   template <typename T> constexpr bool is_multiplication_safe(T a, T b) {
-    if ((a >= 0 && b >= 0) || (a < 0 && b < 0)) {
-      return constlog2(a) + constlog2(b) <=
-             constlog(std::numeric_limits<T>::max());
+    if constexpr (std::is_floating_point_v<T>) {
+      return is_finite_result(a * b);
+    } else if constexpr (std::is_unsigned_v<T>) {
+      return a == 0 || b <= std::numeric_limits<T>::max() / a;
+    } else if (a > 0) {
+      return b > 0 ? a <= std::numeric_limits<T>::max() / b
+                   : b >= std::numeric_limits<T>::lowest() / a;
     } else {
-      return constlog2(a) + constlog2(b) <=
-             constlog(std::numeric_limits<T>::lowest());
+      return b > 0 ? a >= std::numeric_limits<T>::lowest() / b
+                   : a == 0 || b >= std::numeric_limits<T>::max() / a;
     }
   }
 
-  // Implementation of M'
-  template <typename T1, typename T2> struct prod;
-  template <typename T, T Value1, T Value2>
-  struct prod<less_equal<T, Value1>, less_equal<T, Value2>> {
-    static_assert(is_multiplication_safe(Value1, Value2), "Overflow detected");
-    using type = less_equal<T, Value1 * Value2>;
-  };
-  template <typename T, T Value1, T Value2>
-  struct prod<less<T, Value1>, less_equal<T, Value2>> {
-    static_assert(is_multiplication_safe(Value1, Value2), "Overflow detected");
-    using type = less<T, Value1 * Value2>;
-  };
-  template <typename T, T Value1, T Value2>
-  struct prod<less_equal<T, Value1>, less<T, Value2>> {
-    static_assert(is_multiplication_safe(Value1, Value2), "Overflow detected");
-    using type = less<T, Value1 * Value2>;
-  };
-  template <typename T, T Value1, T Value2>
-  struct prod<less<T, Value1>, less<T, Value2>> {
-    static_assert(is_multiplication_safe(Value1, Value2), "Overflow detected");
-    using type = less<T, Value1 * Value2>;
-  };
-  template <typename T1, typename T2>
-  using prod_t = typename prod<T1, T2>::type;
-
   // Implementation of M
-  template <typename T1, typename T2, typename T3, typename T4, bool A, bool B,
-            bool C, bool D>
-  struct mul;
-  template <typename T1, typename T2, typename T3, typename T4>
-  struct mul<T1, T2, T3, T4, true, true, true, true> {
-    using _temp1 = invert_t<T2>;
-    using _temp2 = invert_t<T4>;
-    using _temp3 = invert_t<prod_t<_temp1, _temp2>>;
-
-    using type = and_term<prod_t<T1, T3>, not_term<_temp3>>;
-  };
-  template <typename T1, typename T2, typename T3, typename T4>
-  struct mul<T1, T2, T3, T4, false, false, false, false> {
-    using _temp1 = invert_t<T2>;
-    using _temp2 = invert_t<T4>;
-    using _temp3 = invert_t<prod_t<T1, T3>>;
-
-    using type = and_term<prod_t<_temp1, _temp2>, not_term<_temp3>>;
-  };
-  template <typename T1, typename T2, typename T3, typename T4>
-  struct mul<T1, T2, T3, T4, false, false, true, true> {
-    using _temp1 = invert_t<T2>;
-    using _temp2 = invert_t<T4>;
-    using _temp3 = invert_t<prod_t<_temp1, T3>>;
-
-    using type = and_term<prod_t<T1, _temp2>, not_term<_temp3>>;
-  };
-  template <typename T1, typename T2, typename T3, typename T4>
-  struct mul<T1, T2, T3, T4, true, true, false, false> {
-    using type = typename mul<T3, T4, T1, T2, false, false, true, true>::type;
-  };
-  template <typename T1, typename T2, typename T3, typename T4>
-  struct mul<T1, T2, T3, T4, true, false, true, true> {
-    using _temp1 = invert_t<T2>;
-    using _temp2 = invert_t<prod_t<_temp1, T3>>;
-
-    using type = and_term<prod_t<T1, T3>, not_term<_temp2>>;
-  };
-  template <typename T1, typename T2, typename T3, typename T4>
-  struct mul<T1, T2, T3, T4, true, true, true, false> {
-    using type = typename mul<T3, T4, T1, T2, true, false, true, true>::type;
-  };
-  template <typename T1, typename T2, typename T3, typename T4>
-  struct mul<T1, T2, T3, T4, true, false, false, false> {
-    using _temp1 = invert_t<T2>;
-    using _temp2 = invert_t<T4>;
-    using _temp3 = invert_t<prod_t<_temp1, _temp2>>;
+  /*
+   The product of two intervals lies between the smallest and the largest of
+   the products of their bounds, whatever their signs, and both are attained:
+   this is the tightest interval containing every product. Bounds are made
+   inclusive first, see `inclusive_bound`.
+  */
+  template <typename T>
+  constexpr interval<T> multiply(interval<T> x, interval<T> y) {
+    T corners[4] = {static_cast<T>(x.lowest * y.lowest),
+                    static_cast<T>(x.lowest * y.highest),
+                    static_cast<T>(x.highest * y.lowest),
+                    static_cast<T>(x.highest * y.highest)};
+    interval<T> res = {corners[0], corners[0], false};
+    for (auto c : corners) {
+      res.lowest = c < res.lowest ? c : res.lowest;
+      res.highest = c > res.highest ? c : res.highest;
+    }
+    return res;
+  }
 
-    using type = and_term<prod_t<T1, _temp2>, not_term<_temp3>>;
-  };
-  template <typename T1, typename T2, typename T3, typename T4>
-  struct mul<T1, T2, T3, T4, false, false, true, false> {
-    using type = typename mul<T3, T4, T1, T2, false, false, false, true>::type;
-  };
-  template <typename T1, typename T2, typename T3, typename T4>
-  struct mul<T1, T2, T3, T4, true, false, true, false> {
-    using _temp1 = invert_t<T2>;
-    using _temp2 = invert_t<T4>;
-    using _temp3 = invert_t<prod_t<_temp1, _temp2>>;
+  // Whether every product of the values of two non-empty intervals fits in `T`
+  template <typename T>
+  constexpr bool is_multiplication_safe(interval<T> x, interval<T> y) {
+    return is_multiplication_safe(x.lowest, y.lowest) &&
+           is_multiplication_safe(x.lowest, y.highest) &&
+           is_multiplication_safe(x.highest, y.lowest) &&
+           is_multiplication_safe(x.highest, y.highest);
+  }
 
-    using _temp4 = prod_t<T1, T3>;
-    using _temp5 = cmax_t<_temp4, _temp3>;
+  template <typename I1, typename I2> struct mul {
+    static constexpr auto x = interval_of<I1>::value;
+    static constexpr auto y = interval_of<I2>::value;
+    using T = std::remove_const_t<decltype(x.lowest)>;
 
-    using _temp6 = prod_t<T1, _temp2>;
-    using _temp7 = prod_t<_temp1, T3>;
-    using _temp8 = invert_t<cmin_t<_temp6, _temp7>>;
+    static constexpr bool empty = x.empty || y.empty;
+    static constexpr bool is_safe = empty || is_multiplication_safe(x, y);
+    static_assert(is_safe, "Overflow detected");
 
-    using type = and_term<_temp5, not_term<_temp8>>;
+    static constexpr interval<T> value = empty || !is_safe ? x : multiply(x, y);
+    using type = std::conditional_t<
+     empty,
+     and_term<less<T, std::numeric_limits<T>::lowest()>,
+              not_term<less<T, std::numeric_limits<T>::lowest()>>>,
+     outward_t<and_term<less_equal<T, value.highest>,
+                        not_term<less<T, value.lowest>>>>>;
   };
-  template <typename T1, typename T2, typename T3, typename T4>
-  using mul_t =
-   typename mul<T1, T2, T3, T4, (bound_value<T1> >= 0), (bound_value<T2> >= 0),
-                (bound_value<T3> >= 0), (bound_value<T4> >= 0)>::type;
 
   // Calculates M(phi_1, phi_2, phi_3, phi_4) given psi_1 and psi_2
   template <typename T1, typename T2> struct mul_helper;
   template <typename T1, typename T2, typename T3, typename T4>
   struct mul_helper<and_term<T1, not_term<T2>>, and_term<T3, not_term<T4>>> {
-    using type = mul_t<T1, T2, T3, T4>;
+    using type = typename mul<and_term<T1, not_term<T2>>,
+                              and_term<T3, not_term<T4>>>::type;
   };
   template <typename T1, typename T2>
   using mul_helper_t = typename mul_helper<T1, T2>::type;
@@ -367,6 +530,258 @@ namespace logic {
                           mul_type_t<or_term<T1s...>, or_term<T2s...>>>;
   };
 
+  // Arithmetic following the usual arithmetic conversions
+  /*
+   When the operands of an operation have different types, or are promoted to
+   a wider type (`std::uint8_t + std::uint8_t` is an `int`), the result has
+   type `R`, the type C++ gives to the expression. Its constraint is computed
+   from the exact intervals admitted by the operands (see `domain`): for every
+   pair of intervals the result lies between the smallest and the largest of
+   the four values obtained from their endpoints, evaluated in 128-bit
+   arithmetic. Results that do not fit in `R` are rejected at compile time,
+   including negative results of unsigned types, which would wrap around.
+  */
+  using wide_int = __int128;
+
+  struct add_op {
+    static constexpr bool apply(wide_int a, wide_int b, wide_int &res) {
+      return !__builtin_add_overflow(a, b, &res);
+    }
+  };
+  struct sub_op {
+    static constexpr bool apply(wide_int a, wide_int b, wide_int &res) {
+      return !__builtin_sub_overflow(a, b, &res);
+    }
+  };
+  struct mul_op {
+    static constexpr bool apply(wide_int a, wide_int b, wide_int &res) {
+      return !__builtin_mul_overflow(a, b, &res);
+    }
+  };
+
+  // Intervals converted to `R`, with `fits` false if any value does not fit
+  template <typename R, std::size_t N> struct wide_intervals {
+    interval<R> values[N > 0 ? N : 1];
+    std::size_t count;
+    bool fits;
+
+    constexpr void add(wide_int lowest, wide_int highest) {
+      fits = fits && lowest >= std::numeric_limits<R>::lowest() &&
+             highest <= std::numeric_limits<R>::max();
+      values[count++] = {static_cast<R>(lowest), static_cast<R>(highest),
+                         false};
+    }
+  };
+
+  template <typename R, typename Is> struct or_of_intervals;
+  template <typename R, std::size_t... Is>
+  struct or_of_intervals<R, std::index_sequence<Is...>> {
+    template <auto &Intervals>
+    using type =
+     or_term<and_term<less_equal<R, Intervals.values[Is].highest>,
+                      not_term<less<R, Intervals.values[Is].lowest>>>...>;
+  };
+
+  // Constraint on `R` admitting the values of `C` on `T`
+  template <typename R, typename T, typename C> struct convert_type {
+    static_assert(std::is_integral_v<R> && std::is_integral_v<T>,
+                  "Only integer constraints can be converted");
+    using dom = domain<T, C>;
+
+    static constexpr wide_intervals<R, dom::merged.count> compute() {
+      wide_intervals<R, dom::merged.count> res{{}, 0, true};
+      for (std::size_t i = 0; i < dom::merged.count; ++i) {
+        res.add(dom::merged.values[i].lowest, dom::merged.values[i].highest);
+      }
+      return res;
+    }
+    static constexpr auto intervals = compute();
+    static_assert(intervals.fits, "Value does not fit in the target type");
+
+    using type = typename or_of_intervals<
+     R, std::make_index_sequence<intervals.count>>::template type<intervals>;
+  };
+  template <typename R, typename T, typename C>
+  using convert_type_t = typename convert_type<R, T, C>::type;
+
+  template <typename Op, typename R, typename T, typename C1, typename U,
+            typename C2>
+  struct promoted_type {
+    static_assert(std::is_integral_v<T> && std::is_integral_v<U>,
+                  "Mixed arithmetic is only supported between integer types");
+    using lhs = domain<T, C1>;
+    using rhs = domain<U, C2>;
+    // See `operands`
+    static constexpr bool hull =
+     lhs::merged.count * rhs::merged.count > max_result_intervals;
+    static constexpr std::size_t lhs_count = hull ? 1 : lhs::merged.count;
+    static constexpr std::size_t rhs_count = hull ? 1 : rhs::merged.count;
+    static constexpr std::size_t size = lhs_count * rhs_count;
+
+    static constexpr wide_intervals<R, size> compute() {
+      wide_intervals<R, size> res{{}, 0, true};
+      for (std::size_t i = 0; i < lhs_count; ++i) {
+        for (std::size_t j = 0; j < rhs_count; ++j) {
+          auto a = hull ? interval<T>{lhs::lowest, lhs::highest, false}
+                        : lhs::merged.values[i];
+          auto b = hull ? interval<U>{rhs::lowest, rhs::highest, false}
+                        : rhs::merged.values[j];
+          wide_int corners[4] = {};
+          bool ok = Op::apply(a.lowest, b.lowest, corners[0]) &&
+                    Op::apply(a.lowest, b.highest, corners[1]) &&
+                    Op::apply(a.highest, b.lowest, corners[2]) &&
+                    Op::apply(a.highest, b.highest, corners[3]);
+          wide_int lowest = corners[0];
+          wide_int highest = corners[0];
+          for (auto c : corners) {
+            lowest = c < lowest ? c : lowest;
+            highest = c > highest ? c : highest;
+          }
+          res.add(lowest, highest);
+          res.fits = res.fits && ok;
+        }
+      }
+      return res;
+    }
+    static constexpr auto intervals = compute();
+    static_assert(intervals.fits, "Overflow detected");
+
+    using type = typename or_of_intervals<
+     R, std::make_index_sequence<intervals.count>>::template type<intervals>;
+  };
+  template <typename Op, typename R, typename T, typename C1, typename U,
+            typename C2>
+  using promoted_type_t =
+   typename promoted_type<Op, R, T, C1, U, C2>::type;
+
+  // Convex hull of a constraint
+  /*
+   Smallest interval containing every value admitted by a constraint: `and`
+   terms intersect the intervals of their operands, `or` terms take the
+   smallest interval containing all of them, and negations of non-terminal
+   terms give up and return the whole range of `T`.
+  */
+  template <typename T> struct hull_bounds {
+    T lowest;
+    T highest;
+  };
+
+  template <typename T> constexpr hull_bounds<T> full_hull() {
+    return {std::numeric_limits<T>::lowest(), std::numeric_limits<T>::max()};
+  }
+
+  template <typename T, T Value>
+  constexpr hull_bounds<T> convex_hull(less<T, Value>) {
+    if (Value != std::numeric_limits<T>::lowest()) {
+      return {std::numeric_limits<T>::lowest(), next_down(Value)};
+    }
+    return {std::numeric_limits<T>::lowest(), Value};
+  }
+
+  template <typename T, T Value>
+  constexpr hull_bounds<T> convex_hull(less_equal<T, Value>) {
+    return {std::numeric_limits<T>::lowest(), Value};
+  }
+
+  template <typename T, T Value>
+  constexpr hull_bounds<T> convex_hull(not_term<less<T, Value>>) {
+    return {Value, std::numeric_limits<T>::max()};
+  }
+
+  template <typename T, T Value>
+  constexpr hull_bounds<T> convex_hull(not_term<less_equal<T, Value>>) {
+    if (Value != std::numeric_limits<T>::max()) {
+      return {next_up(Value), std::numeric_limits<T>::max()};
+    }
+    return {Value, std::numeric_limits<T>::max()};
+  }
+
+  template <typename T, typename C>
+  constexpr hull_bounds<T> convex_hull(not_term<C>) {
+    return full_hull<T>();
+  }
+
+  template <typename T, typename... Cs>
+  constexpr hull_bounds<T> convex_hull(and_term<Cs...>) {
+    hull_bounds<T> res = full_hull<T>();
+    hull_bounds<T> hulls[] = {full_hull<T>(),
+                              convex_hull<T>(typename Cs::type{})...};
+    for (auto h : hulls) {
+      res.lowest = h.lowest > res.lowest ? h.lowest : res.lowest;
+      res.highest = h.highest < res.highest ? h.highest : res.highest;
+    }
+    return res;
+  }
+
+  template <typename T, typename... Cs>
+  constexpr hull_bounds<T> convex_hull(or_term<Cs...>) {
+    if constexpr (sizeof...(Cs) == 0) {
+      return full_hull<T>();
+    } else {
+      hull_bounds<T> res = {std::numeric_limits<T>::max(),
+                            std::numeric_limits<T>::lowest()};
+      hull_bounds<T> hulls[] = {convex_hull<T>(typename Cs::type{})...};
+      for (auto h : hulls) {
+        res.lowest = h.lowest < res.lowest ? h.lowest : res.lowest;
+        res.highest = h.highest > res.highest ? h.highest : res.highest;
+      }
+      return res;
+    }
+  }
+
+  // Optimiser hints
+  /*
+   `LOGIC_ASSUME(cond)` lets the compiler assume that `cond` holds, so that
+   comparisons, sign extensions and bounds checks implied by a constraint can
+   be removed from code using the value of a `safe`. Defining
+   `LOGIC_CHECK_ASSUMPTIONS` (e.g. in debug builds) turns every assumption into
+   a check that traps when it does not hold, and defining `LOGIC_NO_ASSUME`
+   drops them altogether.
+
+   Before GCC 13 the only way to state an assumption is a branch to
+   `__builtin_unreachable()`, which GCC removes only after loop
+   vectorization: a loop reading `safe` values would then have control flow
+   and stay scalar. `LOGIC_ASSUME_BRANCHES` is defined in that case, and the
+   reads of `safe` values carry no hints.
+  */
+#if defined(LOGIC_CHECK_ASSUMPTIONS)
+#if defined(__GNUC__)
+#define LOGIC_ASSUME(cond) ((cond) ? void(0) : __builtin_trap())
+#else
+#define LOGIC_ASSUME(cond) ((cond) ? void(0) : std::abort())
+#endif
+#elif defined(LOGIC_NO_ASSUME)
+#define LOGIC_ASSUME(cond) void(0)
+#elif defined(__clang__)
+#define LOGIC_ASSUME(cond) __builtin_assume(cond)
+#elif defined(__GNUC__) && __GNUC__ >= 13
+#define LOGIC_ASSUME(cond) __attribute__((assume(cond)))
+#elif defined(__GNUC__)
+#define LOGIC_ASSUME(cond) ((cond) ? void(0) : __builtin_unreachable())
+#define LOGIC_ASSUME_BRANCHES
+#elif defined(_MSC_VER)
+#define LOGIC_ASSUME(cond) __assume(cond)
+#else
+#define LOGIC_ASSUME(cond) void(0)
+#endif
+
+  // Tells the compiler that `value` lies in the convex hull of `C`. For
+  // floating-point types this also rules out NaN and infinities.
+  template <typename T, typename C> constexpr void assume_acceptable(T value) {
+#if defined(LOGIC_ASSUME_BRANCHES)
+    static_cast<void>(value);
+#else
+    constexpr auto hull = convex_hull<T>(typename C::type{});
+    constexpr bool is_float = std::is_floating_point_v<T>;
+    if constexpr (is_float || hull.lowest != std::numeric_limits<T>::lowest()) {
+      LOGIC_ASSUME(value >= hull.lowest);
+    }
+    if constexpr (is_float || hull.highest != std::numeric_limits<T>::max()) {
+      LOGIC_ASSUME(value <= hull.highest);
+    }
+#endif
+  }
+
   template <typename T,
             typename C =
              and_term<less_equal<T, std::numeric_limits<T>::max()>,
@@ -374,17 +789,41 @@ namespace logic {
   class safe {
     T m_value;
     // For internal use only
-    safe() {}
+    constexpr safe() : m_value{} {}
+
+  public:
+    using value_type = T;
+    using constraint = C;
+
+    /*
+     Constraint a value must satisfy to be stored, checked by the constructor
+     and by bulk validation such as `safe_column`. Just like integers always
+     lie in the range of their type, floating-point values are always finite:
+     this is what `normalize` assumes, so NaN and infinities are rejected even
+     where `C` alone would admit them.
+    */
+    using checked_constraint =
+     std::conditional_t<std::is_floating_point_v<T>, and_term<finite<T>, C>,
+                        C>;
+
+  private:
+    static constexpr bool accepts(T value) {
+      return is_acceptable(value, checked_constraint{});
+    }
 
   public:
-    static safe _unsafe_create(T value) {
+
+    static constexpr safe _unsafe_create(T value) {
+#ifdef LOGIC_INSTRUMENT
+      instrument::on_unchecked<T, C>();
+#endif
       safe s{};
       s.m_value = value;
       return s;
     }
 
     template <T Value> static constexpr safe make_safe() {
-      static_assert(is_acceptable(Value, C{}), "Value is not acceptable");
+      static_assert(accepts(Value), "Value is not acceptable");
       safe s{};
       s.m_value = Value;
       return s;
@@ -402,44 +841,88 @@ namespace logic {
         }
 #endif
 
-    template <typename C2> safe(safe<T, C2> value) : m_value(value) {
+    template <typename C2>
+    constexpr safe(safe<T, C2> value) : m_value(value) {
       static_assert(truth_value<sequent<list<C2>, list<C>>>, "Invalid value");
     }
 
-    safe(T value) : m_value(value) {
-      if (!is_acceptable(value, C{})) {
+    // Conversion between integer types, e.g. storing the result of an
+    // operation on narrow values back into a narrow type
+    template <typename U, typename C2,
+              typename = std::enable_if_t<!std::is_same_v<T, U>>>
+    constexpr safe(safe<U, C2> value) : m_value(static_cast<T>(U(value))) {
+      static_assert(
+       truth_value<sequent<list<convert_type_t<T, U, C2>>, list<C>>>,
+       "Invalid value");
+    }
+
+    constexpr safe(T value) : m_value(value) {
+#ifdef LOGIC_INSTRUMENT
+      instrument::on_checked<T, C>(accepts(value));
+#endif
+      if (!accepts(value)) {
         throw std::range_error{"value"};
       }
     }
 
-    template <typename C2> safe &operator=(const safe<T, C2> &value) {
+    template <typename C2>
+    constexpr safe &operator=(const safe<T, C2> &value) {
       static_assert(truth_value<sequent<list<C2>, list<C>>>, "Invalid value");
       m_value = value;
       return *this;
     }
 
-    template <typename C2> auto operator+(const safe<T, C2> &value) {
-      auto res = safe<
-       T, sum_type_t<normalize_t<T, typename C::type>,
-                     normalize_t<T, typename C2::type>>>::_unsafe_create(value);
-      return res;
+    /*
+     Operations between values of the same type that is not promoted follow
+     the rules of the thesis and give a value of that type; every other
+     combination gives a value of the promoted type, see `promoted_type`.
+    */
+    template <typename U, typename C2>
+    auto operator+(const safe<U, C2> &value) const {
+      using R = decltype(T{} + U{});
+      if constexpr (std::is_same_v<T, U> && std::is_same_v<R, T>) {
+        using ops = operands<T, normalize_t<T, typename C::type>,
+                             normalize_t<T, typename C2::type>>;
+        return safe<T, sum_type_t<typename ops::lhs, typename ops::rhs>>::
+         _unsafe_create(static_cast<T>(T(*this) + T(value)));
+      } else {
+        return safe<R, promoted_type_t<add_op, R, T, C, U, C2>>::
+         _unsafe_create(static_cast<R>(T(*this) + U(value)));
+      }
     }
 
-    template <typename C2> auto operator-(const safe<T, C2> &value) {
-      auto res = safe<
-       T, sub_type_t<normalize_t<T, typename C::type>,
-                     normalize_t<T, typename C2::type>>>::_unsafe_create(value);
-      return res;
+    template <typename U, typename C2>
+    auto operator-(const safe<U, C2> &value) const {
+      using R = decltype(T{} - U{});
+      if constexpr (std::is_same_v<T, U> && std::is_same_v<R, T>) {
+        using ops = operands<T, normalize_t<T, typename C::type>,
+                             normalize_t<T, typename C2::type>>;
+        return safe<T, sub_type_t<typename ops::lhs, typename ops::rhs>>::
+         _unsafe_create(static_cast<T>(T(*this) - T(value)));
+      } else {
+        return safe<R, promoted_type_t<sub_op, R, T, C, U, C2>>::
+         _unsafe_create(static_cast<R>(T(*this) - U(value)));
+      }
     }
 
-    template <typename C2> auto operator*(const safe<T, C2> &value) {
-      auto res = safe<
-       T, mul_type_t<normalize_t<T, typename C::type>,
-                     normalize_t<T, typename C2::type>>>::_unsafe_create(value);
-      return res;
+    template <typename U, typename C2>
+    auto operator*(const safe<U, C2> &value) const {
+      using R = decltype(T{} * U{});
+      if constexpr (std::is_same_v<T, U> && std::is_same_v<R, T>) {
+        using ops = operands<T, normalize_t<T, typename C::type>,
+                             normalize_t<T, typename C2::type>>;
+        return safe<T, mul_type_t<typename ops::lhs, typename ops::rhs>>::
+         _unsafe_create(static_cast<T>(T(*this) * T(value)));
+      } else {
+        return safe<R, promoted_type_t<mul_op, R, T, C, U, C2>>::
+         _unsafe_create(static_cast<R>(T(*this) * U(value)));
+      }
     }
 
-    operator T() const { return m_value; }
+    constexpr operator T() const {
+      assume_acceptable<T, C>(m_value);
+      return m_value;
+    }
   };
 
   template <typename T, T Value>
@@ -448,6 +931,31 @@ namespace logic {
     return safe<T, and_term<less_equal<T, Value>, greater_equal<T, Value>>>::
      template make_safe<Value>();
   }
+
+  // Zero-overhead guarantees
+  /*
+   A `safe` is stored, copied and passed exactly like the value it wraps: it
+   has the same size and alignment, and is trivially copyable and destructible
+   so that it is passed in registers. `safe_column` relies on this to view raw
+   values as `safe` ones.
+  */
+  template <typename S>
+  constexpr bool has_raw_layout =
+   std::is_trivially_copyable_v<S> && std::is_trivially_destructible_v<S> &&
+   std::is_standard_layout_v<S> &&
+   sizeof(S) == sizeof(typename S::value_type) &&
+   alignof(S) == alignof(typename S::value_type);
+
+  static_assert(has_raw_layout<safe<signed char>> &&
+                 has_raw_layout<safe<unsigned char>> &&
+                 has_raw_layout<safe<short>> &&
+                 has_raw_layout<safe<unsigned short>> &&
+                 has_raw_layout<safe<int>> && has_raw_layout<safe<unsigned>> &&
+                 has_raw_layout<safe<long>> &&
+                 has_raw_layout<safe<unsigned long>> &&
+                 has_raw_layout<safe<long long>> &&
+                 has_raw_layout<safe<unsigned long long>>,
+                "safe must not add any overhead to the type it wraps");
 } // namespace logic
 
 #endif
\ No newline at end of file
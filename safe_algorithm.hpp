@@ -0,0 +1,209 @@
+#ifndef SAFE_ALGORITHM_HPP
+#define SAFE_ALGORITHM_HPP
+#include "safe_array.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <type_traits>
+
+namespace logic {
+  // Searching in a `safe_array`
+  /*
+   The algorithms below return positions that are proven to be in range, so
+   that they can be used to index the array again without checks:
+    - `find`, `min_element` and `max_element` return an `accessor_type`
+      (wrapped in an `std::optional` for `find`, which may find nothing);
+    - `lower_bound` and `upper_bound` return a `position_type`, which may also
+      be `Size`, one past the last element, like the end iterator returned by
+      the standard algorithms.
+
+   Binary searches are branchless: the range is halved by a conditional move
+   at every step, so that the number of steps only depends on `Size` and no
+   branch can be mispredicted.
+  */
+  template <std::size_t Size>
+  using position_type = safe<std::size_t, less_equal<std::size_t, Size>>;
+
+  // Prefetches the middle elements of both halves of [base, base + n), one of
+  // which is compared in the next step of a binary search
+  template <typename T>
+  constexpr void prefetch_halves(const T *base, std::size_t n) {
+#if defined(__GNUC__)
+    if (!__builtin_is_constant_evaluated()) {
+      __builtin_prefetch(base + n / 4);
+      __builtin_prefetch(base + n / 2 + n / 4);
+    }
+#endif
+  }
+
+  template <typename T, std::size_t Size, typename V,
+            typename Compare = std::less<>>
+  constexpr position_type<Size> lower_bound(const safe_array<T, Size> &arr,
+                                            const V &value,
+                                            Compare comp = {}) {
+    if constexpr (Size == 0) {
+      return position_type<Size>::_unsafe_create(0);
+    } else {
+      const T *first = arr.m_data.data();
+      const T *base = first;
+      for (std::size_t n = Size; n > 1; n -= n / 2) {
+        prefetch_halves(base, n);
+        base = comp(base[n / 2], value) ? base + n / 2 : base;
+      }
+      return position_type<Size>::_unsafe_create(
+       (base - first) + (comp(*base, value) ? 1 : 0));
+    }
+  }
+
+  template <typename T, std::size_t Size, typename V,
+            typename Compare = std::less<>>
+  constexpr position_type<Size> upper_bound(const safe_array<T, Size> &arr,
+                                            const V &value,
+                                            Compare comp = {}) {
+    if constexpr (Size == 0) {
+      return position_type<Size>::_unsafe_create(0);
+    } else {
+      const T *first = arr.m_data.data();
+      const T *base = first;
+      for (std::size_t n = Size; n > 1; n -= n / 2) {
+        prefetch_halves(base, n);
+        base = comp(value, base[n / 2]) ? base : base + n / 2;
+      }
+      return position_type<Size>::_unsafe_create(
+       (base - first) + (comp(value, *base) ? 0 : 1));
+    }
+  }
+
+  template <typename T, std::size_t Size, typename V>
+  constexpr std::optional<typename safe_array<T, Size>::accessor_type>
+  find(const safe_array<T, Size> &arr, const V &value) {
+    using accessor_type = typename safe_array<T, Size>::accessor_type;
+    for (std::size_t i = 0; i < Size; ++i) {
+      if (arr.m_data[i] == value) {
+        return accessor_type::_unsafe_create(i);
+      }
+    }
+    return std::nullopt;
+  }
+
+  template <typename T, std::size_t Size, typename Compare = std::less<>>
+  constexpr typename safe_array<T, Size>::accessor_type
+  min_element(const safe_array<T, Size> &arr, Compare comp = {}) {
+    static_assert(Size > 0, "An empty array has no minimum");
+    std::size_t res = 0;
+    for (std::size_t i = 1; i < Size; ++i) {
+      res = comp(arr.m_data[i], arr.m_data[res]) ? i : res;
+    }
+    return safe_array<T, Size>::accessor_type::_unsafe_create(res);
+  }
+
+  template <typename T, std::size_t Size, typename Compare = std::less<>>
+  constexpr typename safe_array<T, Size>::accessor_type
+  max_element(const safe_array<T, Size> &arr, Compare comp = {}) {
+    static_assert(Size > 0, "An empty array has no maximum");
+    std::size_t res = 0;
+    for (std::size_t i = 1; i < Size; ++i) {
+      res = comp(arr.m_data[res], arr.m_data[i]) ? i : res;
+    }
+    return safe_array<T, Size>::accessor_type::_unsafe_create(res);
+  }
+
+  // Search tree in Eytzinger order
+  /*
+   Copy of a sorted array laid out like a binary heap: the children of the
+   element at position `k` are at `2k` and `2k + 1`, starting from 1. The
+   first levels of the tree, visited by every search, share a few cache lines,
+   and the elements visited a few steps ahead can be prefetched, which makes
+   repeated searches in large arrays much faster than a binary search on the
+   sorted array.
+
+   Searches return positions in the sorted array: every node also stores the
+   position of its element in the sorted array (the empty node 0 stores
+   `Size`). A search always ends on a node it has visited, so reading the
+   position does not miss the cache as a separate table would.
+  */
+  template <typename T, std::size_t Size> class eytzinger_array {
+    static_assert(Size > 0, "Empty search tree");
+    static_assert(std::is_default_constructible_v<T>,
+                  "Elements must be default constructible");
+
+    using rank_type = std::conditional_t<(Size < 0xFFFFFFFFu), std::uint32_t,
+                                         std::size_t>;
+    struct node {
+      T value;
+      rank_type rank;
+    };
+    alignas(64) std::array<node, Size + 1> m_nodes{};
+
+    static constexpr std::size_t prefetch_stride =
+     sizeof(node) < 64 ? 64 / sizeof(node) : 1;
+
+    // Fills the subtree rooted at `k` with the sorted elements from `i` on
+    constexpr std::size_t fill(const safe_array<T, Size> &sorted,
+                               std::size_t i, std::size_t k) {
+      if (k <= Size) {
+        i = fill(sorted, i, 2 * k);
+        m_nodes[k] = {sorted.m_data[i], static_cast<rank_type>(i)};
+        ++i;
+        i = fill(sorted, i, 2 * k + 1);
+      }
+      return i;
+    }
+
+    constexpr void prefetch(std::size_t k) const {
+#if defined(__GNUC__)
+      if (!__builtin_is_constant_evaluated()) {
+        auto ahead = k * prefetch_stride;
+        __builtin_prefetch(m_nodes.data() + (ahead < Size ? ahead : Size));
+      }
+#endif
+    }
+
+    // Position in the sorted array of the last element visited by a search
+    // ending at `k`, after going right past it
+    constexpr position_type<Size> position(std::size_t k) const {
+#if defined(__GNUC__)
+      k >>= __builtin_ctzll(~static_cast<unsigned long long>(k)) + 1;
+#else
+      while (k & 1) {
+        k >>= 1;
+      }
+      k >>= 1;
+#endif
+      return position_type<Size>::_unsafe_create(m_nodes[k].rank);
+    }
+
+  public:
+    // `sorted` must be sorted according to the comparison used in searches
+    constexpr explicit eytzinger_array(const safe_array<T, Size> &sorted) {
+      fill(sorted, 0, 1);
+      m_nodes[0].rank = Size;
+    }
+
+    template <typename V, typename Compare = std::less<>>
+    constexpr position_type<Size> lower_bound(const V &value,
+                                              Compare comp = {}) const {
+      std::size_t k = 1;
+      while (k <= Size) {
+        prefetch(k);
+        k = 2 * k + (comp(m_nodes[k].value, value) ? 1 : 0);
+      }
+      return position(k);
+    }
+
+    template <typename V, typename Compare = std::less<>>
+    constexpr position_type<Size> upper_bound(const V &value,
+                                              Compare comp = {}) const {
+      std::size_t k = 1;
+      while (k <= Size) {
+        prefetch(k);
+        k = 2 * k + (comp(value, m_nodes[k].value) ? 0 : 1);
+      }
+      return position(k);
+    }
+  };
+} // namespace logic
+
+#endif
@@ -5,6 +5,11 @@
 #include <cstddef>
 
 namespace logic {
+  /*
+   `T` can itself be a `safe` type: indexing then yields a value that carries
+   the constraint of the elements, so that lookups can be chained without
+   checks, as in `perm[idx[i]]`.
+  */
   template <typename T, std::size_t Size> struct safe_array {
     std::array<T, Size> m_data;
     using container = decltype(m_data);
@@ -30,8 +35,21 @@ namespace logic {
       return m_data[index];
     }
 
-    constexpr std::array<T, Size> &array() const { return m_data; }
+    constexpr std::array<T, Size> &array() { return m_data; }
+    constexpr const std::array<T, Size> &array() const { return m_data; }
   };
+
+  static_assert(sizeof(safe_array<int, 4>) == sizeof(std::array<int, 4>) &&
+                 sizeof(safe_array<safe<int>, 4>) == sizeof(std::array<int, 4>),
+                "safe_array must not add any overhead to std::array");
+
+  // Builds a lookup table whose elements are constrained to be one of
+  // `Values`, so that they can also be dispatched on (see `visit`)
+  template <typename T, T... Values> constexpr auto make_lut() {
+    using element = safe<T, one_of<T, Values...>>;
+    return safe_array<element, sizeof...(Values)>{
+     {element::template make_safe<Values>()...}};
+  }
 } // namespace logic
 
-#endif
\ No newline at end of file
+#endif
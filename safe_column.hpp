@@ -0,0 +1,237 @@
+#ifndef SAFE_COLUMN_HPP
+#define SAFE_COLUMN_HPP
+#include "safe.hpp"
+#include <cerrno>
+#include <cstddef>
+#include <stdexcept>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if __cplusplus >= 202002L && __has_include(<span>)
+#include <span>
+#define LOGIC_HAS_SPAN 1
+#endif
+
+namespace logic {
+  // Read-only memory mapping of a whole file (POSIX only)
+  class mapped_file {
+    int m_fd = -1;
+    const std::byte *m_data = nullptr;
+    std::size_t m_size = 0;
+
+    static std::size_t page_size() {
+      static const std::size_t size = sysconf(_SC_PAGESIZE);
+      return size;
+    }
+
+    void advise(std::size_t offset, std::size_t length, int advice,
+                bool inward) const {
+      auto page = page_size();
+      auto first = inward ? (offset + page - 1) / page * page
+                          : offset / page * page;
+      auto last = inward ? (offset + length) / page * page
+                         : (offset + length + page - 1) / page * page;
+      last = last < m_size ? last : m_size;
+      if (first < last) {
+        ::madvise(const_cast<std::byte *>(m_data) + first, last - first,
+                  advice);
+      }
+    }
+
+  public:
+    explicit mapped_file(const char *path) {
+      m_fd = ::open(path, O_RDONLY);
+      if (m_fd < 0) {
+        throw std::system_error{errno, std::generic_category(), path};
+      }
+      struct stat st;
+      if (::fstat(m_fd, &st) != 0) {
+        auto err = errno;
+        ::close(m_fd);
+        throw std::system_error{err, std::generic_category(), path};
+      }
+      m_size = st.st_size;
+      if (m_size > 0) {
+        void *data = ::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, m_fd, 0);
+        if (data == MAP_FAILED) {
+          auto err = errno;
+          ::close(m_fd);
+          throw std::system_error{err, std::generic_category(), path};
+        }
+        m_data = static_cast<const std::byte *>(data);
+      }
+    }
+
+    mapped_file(mapped_file &&other) noexcept
+     : m_fd(std::exchange(other.m_fd, -1))
+     , m_data(std::exchange(other.m_data, nullptr))
+     , m_size(std::exchange(other.m_size, 0)) {}
+
+    mapped_file &operator=(mapped_file &&other) noexcept {
+      std::swap(m_fd, other.m_fd);
+      std::swap(m_data, other.m_data);
+      std::swap(m_size, other.m_size);
+      return *this;
+    }
+
+    mapped_file(const mapped_file &) = delete;
+    mapped_file &operator=(const mapped_file &) = delete;
+
+    ~mapped_file() {
+      if (m_data) {
+        ::munmap(const_cast<std::byte *>(m_data), m_size);
+      }
+      if (m_fd >= 0) {
+        ::close(m_fd);
+      }
+    }
+
+    const std::byte *data() const { return m_data; }
+    std::size_t size() const { return m_size; }
+
+    void advise_sequential() const {
+      advise(0, m_size, MADV_SEQUENTIAL, false);
+    }
+
+    // Asks the kernel to start reading the given range ahead of time
+    void will_need(std::size_t offset, std::size_t length) const {
+      advise(offset, length, MADV_WILLNEED, false);
+    }
+
+    // Drops the pages fully contained in the given range from memory. They
+    // are read again from the file if accessed later.
+    void release(std::size_t offset, std::size_t length) const {
+      advise(offset, length, MADV_DONTNEED, true);
+    }
+  };
+
+  // Contiguous read-only view of elements living in a mapping
+  template <typename E> class column_view {
+    const E *m_data;
+    std::size_t m_size;
+
+  public:
+    constexpr column_view(const E *data, std::size_t size)
+     : m_data(data), m_size(size) {}
+
+    constexpr const E *data() const { return m_data; }
+    constexpr std::size_t size() const { return m_size; }
+    constexpr bool empty() const { return m_size == 0; }
+    constexpr const E *begin() const { return m_data; }
+    constexpr const E *end() const { return m_data + m_size; }
+    constexpr const E &operator[](std::size_t index) const {
+      return m_data[index];
+    }
+
+#ifdef LOGIC_HAS_SPAN
+    constexpr operator std::span<const E>() const { return {m_data, m_size}; }
+#endif
+  };
+
+  /*
+   A column of `T` values stored in native byte order in a file, from `offset`
+   to the end of the file, validated against `C` (and, for floating-point
+   values, against `finite<T>`, see `safe::checked_constraint`).
+
+   `scan` walks the column in chunks of `chunk_size` elements: each chunk is
+   validated in bulk and handed out as views of `safe<T, C>` pointing straight
+   into the mapping. Elements that fail validation split the chunk into runs
+   and are reported to `on_invalid` together with their position. While a
+   chunk is being processed the next one is read ahead, and once it is done its
+   pages are released, so resident memory stays bounded by a few chunks even
+   for files larger than memory. Views stay valid as long as the column: pages
+   that were released are read back from the file on access.
+
+   Files storing narrow values are read with a narrow `T`, e.g.
+   `safe_column<std::uint8_t, less<std::uint8_t, 200>>`; the constraint is
+   checked on the stored width.
+  */
+  template <typename T, typename C> class safe_column {
+  public:
+    using element_type = safe<T, C>;
+    using view_type = column_view<element_type>;
+
+    static_assert(has_raw_layout<element_type>,
+                  "safe values must have the same layout as their type");
+
+    static constexpr std::size_t default_chunk_size =
+     (std::size_t{16} << 20) / sizeof(T);
+
+  private:
+    mapped_file m_file;
+    std::size_t m_offset;
+    std::size_t m_size;
+
+    const T *raw() const {
+      return reinterpret_cast<const T *>(m_file.data() + m_offset);
+    }
+
+  public:
+    explicit safe_column(const char *path, std::size_t offset = 0)
+     : m_file(path), m_offset(offset) {
+      if (offset > m_file.size() || offset % alignof(T) != 0) {
+        throw std::invalid_argument{"offset"};
+      }
+      m_size = (m_file.size() - offset) / sizeof(T);
+      m_file.advise_sequential();
+    }
+
+    std::size_t size() const { return m_size; }
+
+    /*
+     Calls `on_valid(position, view)` for every run of valid elements and
+     `on_invalid(position, value)` for every invalid one, in order.
+    */
+    template <typename OnValid, typename OnInvalid>
+    void scan(OnValid &&on_valid, OnInvalid &&on_invalid,
+              std::size_t chunk_size = default_chunk_size) const {
+      if (chunk_size == 0) {
+        throw std::invalid_argument{"chunk_size"};
+      }
+      const T *data = raw();
+      auto elements =
+       reinterpret_cast<const element_type *>(m_file.data() + m_offset);
+      for (std::size_t chunk = 0; chunk < m_size; chunk += chunk_size) {
+        auto end = chunk + chunk_size < m_size ? chunk + chunk_size : m_size;
+        if (end < m_size) {
+          m_file.will_need(m_offset + end * sizeof(T),
+                           (m_size - end < chunk_size ? m_size - end
+                                                      : chunk_size) *
+                            sizeof(T));
+        }
+        for (auto pos = chunk; pos < end;) {
+          auto valid =
+           find_unacceptable<typename element_type::checked_constraint>(
+            data + pos, end - pos);
+          if (valid > 0) {
+            on_valid(pos, view_type{elements + pos, valid});
+          }
+          pos += valid;
+          if (pos < end) {
+            on_invalid(pos, data[pos]);
+            ++pos;
+          }
+        }
+        m_file.release(m_offset + chunk * sizeof(T), (end - chunk) * sizeof(T));
+      }
+    }
+
+    // Returns a view of the whole column, throwing `std::range_error` if any
+    // element is invalid
+    view_type validate_all() const {
+      scan([](std::size_t, view_type) {},
+           [](std::size_t, T) { throw std::range_error{"value"}; });
+      return view_type{
+       reinterpret_cast<const element_type *>(m_file.data() + m_offset),
+       m_size};
+    }
+  };
+} // namespace logic
+
+#endif
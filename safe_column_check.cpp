@@ -0,0 +1,146 @@
+// Reads columns written to temporary files with `safe_column` and checks the
+// runs of valid elements and the invalid elements it reports (POSIX only).
+// Build with e.g.
+//   g++ -std=c++20 -I. safe_column_check.cpp
+#include "safe_column.hpp"
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+#include <system_error>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace logic;
+
+// File holding the bytes of `values`, removed on destruction
+class temp_file {
+  char m_path[32] = "/tmp/safe_column_XXXXXX";
+
+public:
+  template <typename T> explicit temp_file(const std::vector<T> &values) {
+    int fd = ::mkstemp(m_path);
+    if (fd < 0) {
+      throw std::system_error{errno, std::generic_category(), m_path};
+    }
+    auto size = values.size() * sizeof(T);
+    bool written = ::write(fd, values.data(), size) == ssize_t(size);
+    ::close(fd);
+    if (!written) {
+      ::unlink(m_path);
+      throw std::runtime_error{m_path};
+    }
+  }
+
+  temp_file(const temp_file &) = delete;
+  temp_file &operator=(const temp_file &) = delete;
+
+  ~temp_file() { ::unlink(m_path); }
+
+  const char *path() const { return m_path; }
+};
+
+// Run of valid elements, or single invalid element, reported by `scan`
+struct event {
+  bool valid;
+  std::size_t position;
+  std::size_t size;
+
+  bool operator==(const event &other) const {
+    return valid == other.valid && position == other.position &&
+           size == other.size;
+  }
+};
+
+int failures = 0;
+
+void check(bool ok, const char *what) {
+  if (!ok) {
+    std::printf("FAILED: %s\n", what);
+    ++failures;
+  }
+}
+
+// Scans `column`, which was written from `values`, checking that views point
+// to the stored values and that invalid elements are reported with their value
+template <typename T, typename C>
+std::vector<event> scan_events(const safe_column<T, C> &column,
+                               const std::vector<T> &values,
+                               std::size_t chunk_size) {
+  using view_type = typename safe_column<T, C>::view_type;
+  std::vector<event> events;
+  bool same_values = true;
+  column.scan(
+   [&](std::size_t pos, view_type view) {
+     for (std::size_t i = 0; i < view.size(); ++i) {
+       same_values = same_values && T(view[i]) == values[pos + i];
+     }
+     events.push_back({true, pos, view.size()});
+   },
+   [&](std::size_t pos, T value) {
+     // NaN is the only value different from itself
+     same_values = same_values && (value == values[pos] || value != value);
+     events.push_back({false, pos, 1});
+   },
+   chunk_size);
+  check(same_values, "scan hands out the stored values");
+  return events;
+}
+
+int main() {
+  constexpr double inf = std::numeric_limits<double>::infinity();
+  std::vector<double> reals = {
+   1.0, -inf, std::numeric_limits<double>::quiet_NaN(), 20.0, 2.0};
+  temp_file reals_file{reals};
+  safe_column<double, between_inclusive<double, 0.0, 10.0>> real_column{
+   reals_file.path()};
+  check(real_column.size() == 5, "size of a column of doubles");
+  check(scan_events(real_column, reals, 1024) ==
+         std::vector<event>{{true, 0, 1},
+                            {false, 1, 1},
+                            {false, 2, 1},
+                            {false, 3, 1},
+                            {true, 4, 1}},
+        "infinities, NaN and values out of range are invalid");
+  bool thrown = false;
+  try {
+    real_column.validate_all();
+  } catch (const std::range_error &) {
+    thrown = true;
+  }
+  check(thrown, "validate_all throws on invalid elements");
+
+  std::vector<int> ints = {1, 2, 3, -5, 4, 5, 6, 7, 8, 9};
+  temp_file ints_file{ints};
+  safe_column<int, between_inclusive<int, 0, 100>> int_column{ints_file.path()};
+  check(scan_events(int_column, ints, 1024) ==
+         std::vector<event>{{true, 0, 3}, {false, 3, 1}, {true, 4, 6}},
+        "runs are split around an invalid element");
+  check(scan_events(int_column, ints, 4) ==
+         std::vector<event>{{true, 0, 3},
+                            {false, 3, 1},
+                            {true, 4, 4},
+                            {true, 8, 2}},
+        "runs are split at chunk boundaries");
+
+  // The first four elements act as a header, skipped with an offset
+  safe_column<int, between_inclusive<int, 0, 100>> tail{ints_file.path(),
+                                                        4 * sizeof(int)};
+  auto view = tail.validate_all();
+  check(view.size() == 6 && int(view[0]) == 4 && int(view[5]) == 9,
+        "validate_all returns every element after the offset");
+
+  thrown = false;
+  try {
+    safe_column<int, between_inclusive<int, 0, 100>> misaligned{
+     ints_file.path(), 1};
+  } catch (const std::invalid_argument &) {
+    thrown = true;
+  }
+  check(thrown, "a misaligned offset is rejected");
+
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,65 @@
+#ifndef SAFE_COUNTER_HPP
+#define SAFE_COUNTER_HPP
+#include "safe.hpp"
+#include <type_traits>
+
+namespace logic {
+  /*
+   Loop counter going from `Lo` up to `Hi` in steps of `Step`, whose reads are
+   values of the fixed type `safe<T, between_inclusive<T, Lo, Hi>>`.
+
+   Adding to a `safe` gives a value of a new type, so a `safe` cannot be used
+   as a loop variable. A counter instead keeps its type across increments:
+   increments are not checked, and a counter may step past `Hi` (which cannot
+   overflow, see the assertions below), but then it is `done()` and must not
+   be read any more. The only check left is the exit condition of the loop,
+   so that the generated code is the same as a plain `for` loop:
+
+      for (safe_counter<std::size_t, 0, 99> i; !i.done(); ++i) {
+        arr[*i] = 0;
+      }
+
+   or, equivalently, `for (auto i : safe_counter<std::size_t, 0, 99>{})`.
+  */
+  template <typename T, T Lo, T Hi, T Step = 1> class safe_counter {
+    static_assert(std::is_integral_v<T>, "Counters must be integers");
+    static_assert(Lo <= Hi, "Empty counter range");
+    static_assert(Step > 0, "Counters must move forward");
+    static_assert(is_addition_safe(Hi, Step), "Overflow detected");
+
+    T m_value;
+
+  public:
+    using value_type = safe<T, between_inclusive<T, Lo, Hi>>;
+    using step_type = decltype(make_safe<T, Step>());
+
+    constexpr safe_counter() : m_value(Lo) {}
+    constexpr explicit safe_counter(value_type start) : m_value(start) {}
+
+    constexpr bool done() const { return m_value > Hi; }
+
+    constexpr value_type operator*() const {
+      return value_type::_unsafe_create(m_value);
+    }
+
+    constexpr safe_counter &operator++() {
+      m_value += Step;
+      return *this;
+    }
+
+    constexpr safe_counter &operator+=(step_type) {
+      m_value += Step;
+      return *this;
+    }
+
+    // Range-based for loops compare the counter against this sentinel
+    struct sentinel {};
+
+    constexpr safe_counter begin() const { return *this; }
+    constexpr sentinel end() const { return {}; }
+
+    constexpr bool operator!=(sentinel) const { return !done(); }
+  };
+} // namespace logic
+
+#endif
@@ -0,0 +1,106 @@
+#ifndef SAFE_DISPATCH_HPP
+#define SAFE_DISPATCH_HPP
+#include "safe.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdlib>
+#include <type_traits>
+#include <utility>
+
+namespace logic {
+  // Jump tables over the values admitted by a constraint
+  /*
+   `dispatch(s, f)` calls `f.template operator()<V>()` where `V` is the value
+   held by `s`; `visit(s, f)` calls `f(std::integral_constant<T, V>{})`
+   instead, which works with generic lambdas.
+
+   Since the constraint of `s` guarantees that its value is one of the members
+   of the domain, the call goes through a table with one entry per member and
+   no range check:
+    - dense domains (spanning less than twice their cardinality) are indexed
+      by `value - lowest`;
+    - sparse domains are indexed through the perfect hash of `value_lookup`,
+      or the position in a sorted table if no hash is found.
+   Table slots that no member maps to point to `unreachable_entry`.
+  */
+  // Lets the optimiser drop the slots with `LOGIC_ASSUME`, and traps where
+  // assumptions are checked or unavailable
+  [[noreturn]] inline void unreachable() {
+    LOGIC_ASSUME(false);
+#if defined(__GNUC__)
+    __builtin_trap();
+#else
+    std::abort();
+#endif
+  }
+
+  template <typename T, typename C> struct dispatch_domain {
+    using dom = domain<T, C>;
+    static constexpr std::uint64_t max_size = 4096;
+    static_assert(!dom::empty, "Cannot dispatch on an empty domain");
+    static_assert(dom::cardinality <= max_size,
+                  "Domain is too large for dispatch");
+
+    static constexpr std::size_t size = dom::cardinality;
+    static constexpr std::array<T, size> members =
+     dom::template members<size>();
+
+    template <typename Is> struct make_lookup;
+    template <std::size_t... Is>
+    struct make_lookup<std::index_sequence<Is...>> {
+      using type = value_lookup<2 * size, T, members[Is]...>;
+    };
+    using lookup =
+     typename make_lookup<std::make_index_sequence<size>>::type;
+  };
+
+  template <typename T, typename C, typename R, typename F>
+  struct dispatch_table {
+    using lookup = typename dispatch_domain<T, C>::lookup;
+    using entry = R (*)(F &);
+
+    template <T Value> static constexpr R call_entry(F &f) {
+      return f.template operator()<Value>();
+    }
+    static R unreachable_entry(F &) { unreachable(); }
+
+    template <std::size_t I> static constexpr entry make_entry() {
+      if constexpr (lookup::has_member(I)) {
+        return &call_entry<lookup::member(I)>;
+      } else {
+        return &unreachable_entry;
+      }
+    }
+    template <std::size_t... Is>
+    static constexpr std::array<entry, sizeof...(Is)>
+    make_entries(std::index_sequence<Is...>) {
+      return {make_entry<Is>()...};
+    }
+    static constexpr std::array<entry, lookup::index_size> entries =
+     make_entries(std::make_index_sequence<lookup::index_size>{});
+  };
+
+  template <typename T, typename C, typename F>
+  constexpr decltype(auto) dispatch(safe<T, C> s, F &&f) {
+    using fn = std::remove_reference_t<F>;
+    using R = decltype(
+     f.template operator()<dispatch_domain<T, C>::members[0]>());
+    using table = dispatch_table<T, C, R, fn>;
+    return table::entries[table::lookup::index(s)](f);
+  }
+
+  template <typename T, typename F> struct constant_visitor {
+    F &f;
+    template <T Value> constexpr decltype(auto) operator()() {
+      return f(std::integral_constant<T, Value>{});
+    }
+  };
+
+  template <typename T, typename C, typename F>
+  constexpr decltype(auto) visit(safe<T, C> s, F &&f) {
+    constant_visitor<T, std::remove_reference_t<F>> visitor{f};
+    return dispatch(s, visitor);
+  }
+} // namespace logic
+
+#endif
@@ -0,0 +1,286 @@
+#ifndef SAFE_INSTRUMENT_HPP
+#define SAFE_INSTRUMENT_HPP
+#include "logic.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+namespace logic {
+  namespace instrument {
+    // Readable names of constraints, e.g. "int: (x < 20) && (x > 10)"
+    template <typename T> std::string type_name() {
+      if constexpr (std::is_same_v<T, bool>) {
+        return "bool";
+      } else if constexpr (std::is_same_v<T, char>) {
+        return "char";
+      } else if constexpr (std::is_same_v<T, signed char>) {
+        return "signed char";
+      } else if constexpr (std::is_same_v<T, unsigned char>) {
+        return "unsigned char";
+      } else if constexpr (std::is_same_v<T, short>) {
+        return "short";
+      } else if constexpr (std::is_same_v<T, unsigned short>) {
+        return "unsigned short";
+      } else if constexpr (std::is_same_v<T, int>) {
+        return "int";
+      } else if constexpr (std::is_same_v<T, unsigned>) {
+        return "unsigned";
+      } else if constexpr (std::is_same_v<T, long>) {
+        return "long";
+      } else if constexpr (std::is_same_v<T, unsigned long>) {
+        return "unsigned long";
+      } else if constexpr (std::is_same_v<T, long long>) {
+        return "long long";
+      } else if constexpr (std::is_same_v<T, unsigned long long>) {
+        return "unsigned long long";
+      } else if constexpr (std::is_same_v<T, float>) {
+        return "float";
+      } else if constexpr (std::is_same_v<T, double>) {
+        return "double";
+      } else {
+        return typeid(T).name();
+      }
+    }
+
+    template <typename T> std::string value_name(T value) {
+      if constexpr (std::is_integral_v<T> && sizeof(T) < sizeof(int)) {
+        return std::to_string(static_cast<int>(value));
+      } else {
+        return std::to_string(value);
+      }
+    }
+
+    template <typename... Cs> std::string describe(and_term<Cs...>);
+    template <typename... Cs> std::string describe(or_term<Cs...>);
+    template <typename T, T... Vs> std::string describe(one_of<T, Vs...>);
+    template <typename C,
+              typename = std::enable_if_t<!std::is_same_v<typename C::type, C>>>
+    std::string describe(C);
+
+    template <typename T, T Value> std::string describe(less<T, Value>) {
+      return "x < " + value_name(Value);
+    }
+
+    template <typename T, T Value> std::string describe(less_equal<T, Value>) {
+      return "x <= " + value_name(Value);
+    }
+
+    template <typename T, T Value>
+    std::string describe(not_term<less<T, Value>>) {
+      return "x >= " + value_name(Value);
+    }
+
+    template <typename T, T Value>
+    std::string describe(not_term<less_equal<T, Value>>) {
+      return "x > " + value_name(Value);
+    }
+
+    template <typename C> std::string describe(not_term<C>) {
+      return "!(" + describe(C{}) + ")";
+    }
+
+    template <typename... Cs>
+    std::string join(const char *empty, const char *separator, Cs... cs) {
+      std::string res;
+      if constexpr (sizeof...(Cs) > 0) {
+        for (auto &term : {describe(cs)...}) {
+          res += res.empty() ? "(" : std::string{separator} + "(";
+          res += term + ")";
+        }
+      }
+      return res.empty() ? empty : res;
+    }
+
+    template <typename... Cs> std::string describe(and_term<Cs...>) {
+      return join("true", " && ", Cs{}...);
+    }
+
+    template <typename... Cs> std::string describe(or_term<Cs...>) {
+      return join("false", " || ", Cs{}...);
+    }
+
+    template <typename T, T... Vs> std::string describe(one_of<T, Vs...>) {
+      std::string res;
+      for (auto v : {Vs...}) {
+        res += (res.empty() ? "x in {" : ", ") + value_name(v);
+      }
+      return res + "}";
+    }
+
+    template <typename C, typename>
+    std::string describe(C) {
+      return describe(typename C::type{});
+    }
+
+    template <typename T, typename C> std::string constraint_name() {
+      return type_name<T>() + ": " + describe(C{});
+    }
+
+    // Counters
+    /*
+     Every thread has its own counters for each `safe<T, C>` it uses, only
+     ever written by that thread. `snapshot` adds up the counters of all
+     running threads and those of the threads that have already exited.
+    */
+    struct counts {
+      std::uint64_t checked = 0;
+      std::uint64_t rejected = 0;
+      std::uint64_t unchecked = 0;
+    };
+
+    struct report_entry {
+      std::string constraint;
+      counts values;
+    };
+
+    using name_fn = std::string (*)();
+
+    struct thread_counters;
+
+    class registry {
+      std::mutex m_mutex;
+      std::vector<thread_counters *> m_live;
+      std::vector<std::pair<name_fn, counts>> m_retired;
+
+      static void add(std::vector<std::pair<name_fn, counts>> &totals,
+                      name_fn name, counts c) {
+        auto it = std::find_if(totals.begin(), totals.end(),
+                               [&](auto &e) { return e.first == name; });
+        if (it == totals.end()) {
+          totals.push_back({name, c});
+        } else {
+          it->second.checked += c.checked;
+          it->second.rejected += c.rejected;
+          it->second.unchecked += c.unchecked;
+        }
+      }
+
+    public:
+      static registry &get() {
+        static registry instance;
+        return instance;
+      }
+
+      inline void attach(thread_counters *counters);
+      inline void detach(thread_counters *counters);
+      inline std::vector<report_entry> snapshot();
+    };
+
+    struct thread_counters {
+      name_fn name;
+      std::atomic<std::uint64_t> checked{0};
+      std::atomic<std::uint64_t> rejected{0};
+      std::atomic<std::uint64_t> unchecked{0};
+
+      explicit thread_counters(name_fn n) : name(n) {
+        registry::get().attach(this);
+      }
+      ~thread_counters() { registry::get().detach(this); }
+
+      counts load() const {
+        return {checked.load(std::memory_order_relaxed),
+                rejected.load(std::memory_order_relaxed),
+                unchecked.load(std::memory_order_relaxed)};
+      }
+
+      // Only the owning thread writes, so no atomic read-modify-write is needed
+      static void bump(std::atomic<std::uint64_t> &counter) {
+        counter.store(counter.load(std::memory_order_relaxed) + 1,
+                      std::memory_order_relaxed);
+      }
+    };
+
+    void registry::attach(thread_counters *counters) {
+      std::lock_guard<std::mutex> lock{m_mutex};
+      m_live.push_back(counters);
+    }
+
+    void registry::detach(thread_counters *counters) {
+      std::lock_guard<std::mutex> lock{m_mutex};
+      add(m_retired, counters->name, counters->load());
+      m_live.erase(std::find(m_live.begin(), m_live.end(), counters));
+    }
+
+    std::vector<report_entry> registry::snapshot() {
+      std::vector<std::pair<name_fn, counts>> totals;
+      {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        totals = m_retired;
+        for (auto counters : m_live) {
+          add(totals, counters->name, counters->load());
+        }
+      }
+      std::vector<report_entry> res;
+      for (auto &e : totals) {
+        res.push_back({e.first(), e.second});
+      }
+      std::sort(res.begin(), res.end(), [](auto &a, auto &b) {
+        return a.values.checked + a.values.unchecked >
+               b.values.checked + b.values.unchecked;
+      });
+      return res;
+    }
+
+    template <typename T, typename C> thread_counters &local_counters() {
+      thread_local thread_counters counters{&constraint_name<T, C>};
+      return counters;
+    }
+
+    // Hooks called by `safe`; nothing is counted during constant evaluation
+    template <typename T, typename C> constexpr void on_checked(bool accepted) {
+      if (!__builtin_is_constant_evaluated()) {
+        auto &counters = local_counters<T, C>();
+        thread_counters::bump(counters.checked);
+        if (!accepted) {
+          thread_counters::bump(counters.rejected);
+        }
+      }
+    }
+
+    template <typename T, typename C> constexpr void on_unchecked() {
+      if (!__builtin_is_constant_evaluated()) {
+        thread_counters::bump(local_counters<T, C>().unchecked);
+      }
+    }
+
+    // Reporting
+    inline std::vector<report_entry> snapshot() {
+      return registry::get().snapshot();
+    }
+
+    template <typename F> void dump(F &&callback) {
+      for (auto &entry : snapshot()) {
+        callback(entry);
+      }
+    }
+
+    inline void dump(std::FILE *out) {
+      std::fprintf(out, "%12s %12s %12s  %s\n", "checked", "rejected",
+                   "unchecked", "constraint");
+      dump([&](const report_entry &e) {
+        std::fprintf(out, "%12llu %12llu %12llu  %s\n",
+                     static_cast<unsigned long long>(e.values.checked),
+                     static_cast<unsigned long long>(e.values.rejected),
+                     static_cast<unsigned long long>(e.values.unchecked),
+                     e.constraint.c_str());
+      });
+    }
+
+    inline void dump(const char *path) {
+      std::FILE *out = std::fopen(path, "w");
+      if (!out) {
+        throw std::runtime_error{path};
+      }
+      dump(out);
+      std::fclose(out);
+    }
+  } // namespace instrument
+} // namespace logic
+
+#endif
@@ -0,0 +1,305 @@
+#ifndef SAFE_PARALLEL_HPP
+#define SAFE_PARALLEL_HPP
+#include "safe_array.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace logic {
+  /*
+   Fixed set of worker threads running numbered tasks. The thread calling
+   `run` takes part in the work, and tasks are handed out one at a time from a
+   shared counter, so that threads finishing early pick up the remaining
+   chunks. Calls to `run` from inside a task are executed inline.
+  */
+  class thread_pool {
+    using task_fn = void (*)(void *, std::size_t);
+
+    std::vector<std::thread> m_workers;
+    std::mutex m_run_mutex;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    task_fn m_task = nullptr;
+    void *m_context = nullptr;
+    std::size_t m_tasks = 0;
+    std::atomic<std::size_t> m_next{0};
+    std::atomic<bool> m_failed{false};
+    std::exception_ptr m_error;
+    std::size_t m_busy = 0;
+    std::uint64_t m_generation = 0;
+    bool m_stop = false;
+
+    static bool &inside_pool() {
+      thread_local bool inside = false;
+      return inside;
+    }
+
+    void work() {
+      while (!m_failed.load(std::memory_order_relaxed)) {
+        auto task = m_next.fetch_add(1, std::memory_order_relaxed);
+        if (task >= m_tasks) {
+          break;
+        }
+        try {
+          m_task(m_context, task);
+        } catch (...) {
+          std::lock_guard<std::mutex> lock{m_mutex};
+          if (!m_error) {
+            m_error = std::current_exception();
+          }
+          m_failed = true;
+        }
+      }
+    }
+
+    void worker_loop() {
+      inside_pool() = true;
+      std::uint64_t seen = 0;
+      for (;;) {
+        {
+          std::unique_lock<std::mutex> lock{m_mutex};
+          m_wake.wait(lock, [&] { return m_stop || m_generation != seen; });
+          if (m_stop) {
+            return;
+          }
+          seen = m_generation;
+        }
+        work();
+        std::lock_guard<std::mutex> lock{m_mutex};
+        if (--m_busy == 0) {
+          m_done.notify_one();
+        }
+      }
+    }
+
+  public:
+    static std::size_t default_threads() {
+      auto n = std::thread::hardware_concurrency();
+      return n > 0 ? n : 1;
+    }
+
+    // `threads` counts the thread calling `run` as well
+    explicit thread_pool(std::size_t threads = default_threads()) {
+      for (std::size_t i = 1; i < threads; ++i) {
+        m_workers.emplace_back([this] { worker_loop(); });
+      }
+    }
+
+    thread_pool(const thread_pool &) = delete;
+    thread_pool &operator=(const thread_pool &) = delete;
+
+    ~thread_pool() {
+      {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        m_stop = true;
+      }
+      m_wake.notify_all();
+      for (auto &worker : m_workers) {
+        worker.join();
+      }
+    }
+
+    std::size_t size() const { return m_workers.size() + 1; }
+
+    // Calls `f(task)` for every task in [0, tasks) and waits for all of them.
+    // The first exception thrown by a task is rethrown once all threads stop.
+    template <typename F> void run(std::size_t tasks, F &&f) {
+      if (m_workers.empty() || tasks <= 1 || inside_pool()) {
+        for (std::size_t task = 0; task < tasks; ++task) {
+          f(task);
+        }
+        return;
+      }
+
+      using fn = std::remove_reference_t<F>;
+      std::lock_guard<std::mutex> run_lock{m_run_mutex};
+      {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        m_task = [](void *context, std::size_t task) {
+          (*static_cast<fn *>(context))(task);
+        };
+        m_context = const_cast<std::remove_const_t<fn> *>(&f);
+        m_tasks = tasks;
+        m_next = 0;
+        m_failed = false;
+        m_error = nullptr;
+        m_busy = m_workers.size();
+        ++m_generation;
+      }
+      m_wake.notify_all();
+
+      inside_pool() = true;
+      work();
+      inside_pool() = false;
+
+      std::unique_lock<std::mutex> lock{m_mutex};
+      m_done.wait(lock, [&] { return m_busy == 0; });
+      if (m_error) {
+        std::rethrow_exception(m_error);
+      }
+    }
+
+    static thread_pool &shared() {
+      static thread_pool pool;
+      return pool;
+    }
+  };
+
+  // A range of indices into an array of `Size` elements
+  /*
+   The bounds are checked once, when the range is created; iterating over it
+   yields `accessor_type` values without further checks.
+  */
+  template <std::size_t Size> class index_range {
+    std::size_t m_first;
+    std::size_t m_last;
+
+  public:
+    using accessor_type = safe<std::size_t, less<std::size_t, Size>>;
+
+    class iterator {
+      std::size_t m_index;
+
+    public:
+      constexpr explicit iterator(std::size_t index) : m_index(index) {}
+
+      constexpr accessor_type operator*() const {
+        return accessor_type::_unsafe_create(m_index);
+      }
+      constexpr iterator &operator++() {
+        ++m_index;
+        return *this;
+      }
+      constexpr bool operator!=(const iterator &other) const {
+        return m_index != other.m_index;
+      }
+    };
+
+    constexpr index_range(std::size_t first, std::size_t last)
+     : m_first(first), m_last(last) {
+      if (first > last || last > Size) {
+        throw std::range_error{"index range"};
+      }
+    }
+
+    constexpr std::size_t first() const { return m_first; }
+    constexpr std::size_t last() const { return m_last; }
+    constexpr std::size_t size() const { return m_last - m_first; }
+    constexpr iterator begin() const { return iterator{m_first}; }
+    constexpr iterator end() const { return iterator{m_last}; }
+  };
+
+  // Splitting of [0, Size) into chunks
+  /*
+   Chunks are a multiple of `grain` elements long, where `grain` elements of
+   every array involved fill whole cache lines, and every chunk but the first
+   starts on a cache line boundary of `base`. Threads writing to different
+   chunks therefore never write to the same cache line. This needs an element
+   of `base` to start on a cache line boundary, which is the case whenever
+   `base` is aligned to gcd(cache_line_size, element_size) bytes, e.g. 4 for
+   12-byte elements; otherwise chunks only start every whole number of cache
+   lines.
+  */
+  constexpr std::size_t cache_line_size = 64;
+
+  constexpr std::size_t gcd(std::size_t a, std::size_t b) {
+    return b == 0 ? a : gcd(b, a % b);
+  }
+
+  constexpr std::size_t line_elements(std::size_t element_size) {
+    return cache_line_size / gcd(cache_line_size, element_size);
+  }
+
+  template <std::size_t Size> class chunking {
+    std::size_t m_skew;
+    std::size_t m_chunk;
+    std::size_t m_count;
+
+  public:
+    static constexpr std::size_t min_chunk = 4096;
+
+    chunking(std::size_t grain, const void *base, std::size_t element_size,
+             std::size_t threads) {
+      auto address = reinterpret_cast<std::uintptr_t>(base);
+      // Boundaries repeat every `line_elements` elements, so the first one
+      // is within them if there is any
+      m_skew = 0;
+      for (std::size_t k = 0; k < line_elements(element_size); ++k) {
+        if ((address + k * element_size) % cache_line_size == 0) {
+          m_skew = k;
+          break;
+        }
+      }
+      m_skew = m_skew < Size ? m_skew : 0;
+      auto target = Size / (threads * 8);
+      target = target > min_chunk ? target : min_chunk;
+      m_chunk = (target + grain - 1) / grain * grain;
+      m_count = Size > m_skew ? (Size - m_skew + m_chunk - 1) / m_chunk : 1;
+      m_count += m_skew > 0 ? 1 : 0;
+    }
+
+    std::size_t count() const { return m_count; }
+
+    index_range<Size> operator[](std::size_t chunk) const {
+      auto bound = [&](std::size_t c) -> std::size_t {
+        if (c == 0) {
+          return 0;
+        }
+        auto b = m_skew > 0 ? m_skew + (c - 1) * m_chunk : c * m_chunk;
+        return b < Size ? b : Size;
+      };
+      return {bound(chunk), bound(chunk + 1)};
+    }
+  };
+
+  // Calls `f(range)` on chunks of [0, Size) in parallel. `grain`, `base` and
+  // `element_size` describe the array written to, see `chunking`.
+  template <std::size_t Size, typename F>
+  void parallel_for_chunks(F &&f, std::size_t grain, const void *base,
+                           std::size_t element_size,
+                           thread_pool &pool = thread_pool::shared()) {
+    chunking<Size> chunks{grain, base, element_size, pool.size()};
+    pool.run(chunks.count(), [&](std::size_t chunk) { f(chunks[chunk]); });
+  }
+
+  template <std::size_t Size, typename F>
+  void parallel_for_chunks(F &&f, thread_pool &pool = thread_pool::shared()) {
+    parallel_for_chunks<Size>(std::forward<F>(f), cache_line_size, nullptr, 1,
+                              pool);
+  }
+
+  template <typename T, std::size_t Size, typename F>
+  void parallel_for_each(safe_array<T, Size> &arr, F &&f,
+                         thread_pool &pool = thread_pool::shared()) {
+    parallel_for_chunks<Size>(
+     [&](index_range<Size> range) {
+       for (auto i : range) {
+         f(arr[i]);
+       }
+     },
+     line_elements(sizeof(T)), arr.m_data.data(), sizeof(T), pool);
+  }
+
+  template <typename T, typename U, std::size_t Size, typename F>
+  void parallel_transform(const safe_array<T, Size> &in,
+                          safe_array<U, Size> &out, F &&f,
+                          thread_pool &pool = thread_pool::shared()) {
+    parallel_for_chunks<Size>(
+     [&](index_range<Size> range) {
+       for (auto i : range) {
+         out[i] = f(in[i]);
+       }
+     },
+     line_elements(sizeof(U)), out.m_data.data(), sizeof(U), pool);
+  }
+} // namespace logic
+
+#endif